@@ -135,6 +135,56 @@ ws_getlong(const char *str, long *val)
 	return 0;
 }
 
+int
+ws_getduration(const char *str, long *val)
+{
+	char *eptr;
+	long res, unit;
+
+	errno = 0;
+	res = strtol(str, &eptr, 10);
+
+	if ((res == LONG_MIN || res == LONG_MAX) && errno) {
+		return -1;
+	} else if (eptr == str || res < 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	switch (*eptr) {
+	case 0:
+	case 's':
+		unit = 1;
+		break;
+	case 'm':
+		unit = 60;
+		break;
+	case 'h':
+		unit = 3600;
+		break;
+	case 'd':
+		unit = 86400;
+		break;
+	case 'w':
+		unit = 604800;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (*eptr != 0 && *(eptr + 1) != 0) {
+		errno = EINVAL;
+		return -1;
+	} else if (LONG_MAX / unit < res) {
+		errno = ERANGE;
+		return -1;
+	}
+
+	*val = res * unit;
+	return 0;
+}
+
 int
 ws_getfloat(const char *str, float *val)
 {
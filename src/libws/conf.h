@@ -16,6 +16,12 @@ int ws_getlong(const char *str, long *val);
 int ws_getbool(const char *str, int *val);
 int ws_getfloat(const char *str, float *val);
 
+/*
+ * The ws_getduration() function parses a duration, in seconds. The value
+ * may be suffixed with one of the 's', 'm', 'h', 'd' or 'w' units.
+ */
+int ws_getduration(const char *str, long *val);
+
 /*
  * The ws_parse_config() function parses a configuration file and calls a
  * user defined function on definition lines. The file is composed of lines
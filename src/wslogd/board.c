@@ -6,159 +6,577 @@
 #include "config.h"
 #endif
 
-#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 
+#include "libws/aggregate.h"
+#include "libws/defs.h"
+#include "libws/crc_ccitt.h"
+
 #include "board.h"
 
 #define SHM_NAME "/wslog"		/* Shared memory object name */
-#define SHM_SIZE (16*1024)		/* Shared memory size */
+#define SHM_ALIGN 64			/* Arrays alignment (cache line) */
+#define SEQ_RETRY 1000			/* Max read attempts */
+
+#define BOARD_MAGIC 0x57534c42		/* "WSLB" */
+#define BOARD_VERSION 16		/* Layout version */
+#define BOARD_STATION 32		/* Station name size */
 
+/*
+ * Each circular buffer is protected by a sequence lock.
+ *
+ * There is one writer per buffer (the sensor thread for loop, the archive
+ * thread for archive), which makes the sequence number odd while updating
+ * the buffer. Readers never block the writer: they copy the element out, and
+ * retry when the sequence number changed in the meantime.
+ */
 struct shm_circ
 {
+	atomic_uint seq;		/* Sequence number, odd while writing */
+
 	size_t off;			/* Offset to buffer */
 	size_t sz;			/* Max number of elements */
+	size_t elsz;			/* Element size */
 
 	size_t nel;			/* Number of elements */
 	size_t idx;			/* Next index */
 };
 
+/*
+ * With BOARD_COLUMNS, loop history is also kept in columns (one per field),
+ * sharing the indexes of the loop buffer, so that aggregations only scan the
+ * values they need.
+ *
+ * The area starts with the time column, followed by each value column (see
+ * loop_cols[]), and its validity bitmap. Columns are updated within the loop
+ * buffer write section.
+ */
+struct shm_cols
+{
+	size_t off;			/* Offset to columns */
+	size_t ncols;			/* Number of value columns */
+};
+
+/*
+ * Rolling windows over loop fields (see loop_cols[]), updated by the loop
+ * writer within the loop buffer write section.
+ */
+struct shm_windows
+{
+	size_t n;			/* Number of windows */
+	size_t off[WIN_MAX];		/* Offset to windows */
+	long len[WIN_MAX];		/* Windows length */
+};
+
+/*
+ * Health and throughput counters.
+ *
+ * Each counter is updated with atomic operations by the thread it belongs to
+ * (services, driver and database calls), and read with relaxed loads. They
+ * are reset each time the writer opens the board.
+ */
+struct shm_hist
+{
+	atomic_ulong count;		/* Number of samples */
+	atomic_ullong sum;		/* Sum of samples */
+	atomic_ulong max;		/* Highest sample */
+	atomic_ulong bucket[BOARD_HIST_BUCKETS];
+};
+
+struct shm_srv
+{
+	char name[BOARD_SRV_NAME];	/* Service name */
+	atomic_ulong events;		/* Handled events */
+	atomic_ulong failures;		/* Failed events */
+	atomic_ulong dropped;		/* Dropped notifications */
+	atomic_ulong coalesced;		/* Coalesced notifications */
+	atomic_ulong skipped;		/* Events skipped during backoff */
+	atomic_ulong restarts;		/* Restarts by the supervisor */
+	atomic_int health;		/* Health */
+	atomic_long last_success;	/* Last successful event */
+	struct shm_hist wait;		/* Time spent in queue */
+	struct shm_hist latency;	/* Event handling latency */
+	struct shm_hist age;		/* Sample age when handled */
+};
+
+struct shm_backfill
+{
+	atomic_int state;		/* State */
+	atomic_long from;		/* Last record before backfill */
+	atomic_long current;		/* Last fetched record */
+	atomic_ulong records;		/* Fetched records */
+};
+
+struct shm_writer
+{
+	atomic_ulong saved;		/* Records saved */
+	atomic_ulong lost;		/* Records not saved */
+};
+
+struct shm_log
+{
+	atomic_ulong logged;		/* Messages written to syslog */
+	atomic_ulong repeated;		/* Repeated messages folded */
+	atomic_ulong dropped;		/* Messages dropped */
+};
+
+struct shm_memory
+{
+	atomic_long rss;		/* Resident size, in kB */
+	atomic_long peak;		/* Peak resident size, in kB */
+};
+
+struct shm_stats
+{
+	atomic_size_t nsrv;		/* Number of services */
+	struct shm_srv srv[BOARD_SRV_MAX];
+	struct shm_hist hist[BOARD_HIST_MAX];
+	struct shm_backfill backfill;	/* Archive backfill */
+	struct shm_writer writer;	/* Database writer */
+	struct shm_log log;		/* Logging */
+	struct shm_memory memory;	/* Daemon memory */
+};
+
 struct shm_board
 {
+	uint32_t magic;			/* Magic number */
+	uint16_t version;		/* Layout version */
+	uint16_t cksum;			/* Header checksum */
 	size_t len;			/* Buffer size */
-	pthread_mutex_t mutex;		/* Process-shared */
+	int flags;			/* Board flags */
+	char station[BOARD_STATION];	/* Station name */
+
+	atomic_uint update;		/* Update counter (futex) */
 
 	struct shm_circ ar;		/* Archive array */
 	struct shm_circ loop;		/* Loop array */
+	struct shm_cols cols;		/* Loop columns */
+	struct shm_windows win;		/* Rolling windows */
+
+	struct shm_stats stats;		/* Counters */
+};
+
+static const struct
+{
+	int field;
+	int (*get)(const struct ws_loop *, double *);
+} loop_cols[] =
+{
+	{ WS_BAROMETER, ws_loop_barometer },
+	{ WS_TEMP, ws_loop_temp },
+	{ WS_HUMIDITY, ws_loop_humidity },
+	{ WS_WIND_SPEED, ws_loop_wind_speed },
+	{ WS_WIND_DIR, ws_loop_wind_dir },
+	{ WS_10M_WIND_SPEED, ws_loop_wind_10m_speed },
+	{ WS_HI_WIND_SPEED, ws_loop_hi_wind_10m_speed },
+	{ WS_HI_WIND_DIR, ws_loop_hi_wind_10m_dir },
+	{ WS_RAIN_DAY, ws_loop_rain_day },
+	{ WS_RAIN_1H, ws_loop_rain_1h },
+	{ WS_RAIN_24H, ws_loop_rain_24h },
+	{ WS_RAIN_RATE, ws_loop_rain_rate },
+	{ WS_DEW_POINT, ws_loop_dew_point },
+	{ WS_WINDCHILL, ws_loop_windchill },
+	{ WS_SOLAR_RAD, ws_loop_solar_rad },
+	{ WS_UV_INDEX, ws_loop_uv },
+	{ WS_HEAT_INDEX, ws_loop_heat_index },
+	{ WS_IN_TEMP, ws_loop_in_temp },
+	{ WS_IN_HUMIDITY, ws_loop_in_humidity }
+};
+
+/* Columns masks are 32 bits wide */
+_Static_assert(array_size(loop_cols) <= 32, "too many loop columns");
+
+/*
+ * Board geometry, as requested by the writer.
+ */
+struct shm_geom
+{
+	size_t nloops;			/* Number of loop elements */
+	size_t nar;			/* Number of archive elements */
+	int flags;			/* Board flags */
+	size_t nwin;			/* Number of windows */
+	const long *win;		/* Windows length */
 };
 
+static char shmname[NAME_MAX];		/* Shared memory object name */
 static int shmflag = 0;			/* Open flag */
+static int shmfile = 0;			/* File backed */
 static void *shmbufp = MAP_FAILED;	/* Shared memory */
+static int restored = 0;		/* Content restored */
 
 struct shm_board *boardp = NULL;
 
 static size_t
-shm_board_size(size_t nloops, size_t nar)
+loop_size(int flags)
 {
-	return sizeof(*boardp)
-			+ nloops * sizeof(struct ws_loop)
-			+ nar * sizeof(struct ws_archive);
+	return (flags & BOARD_PACKED) ? sizeof(struct ws_loop_pack) : sizeof(struct ws_loop);
 }
 
-static int
-shm_board_init(size_t len, size_t nloops, size_t nar)
+static size_t
+ar_size(int flags)
 {
-	int errsv;
-	pthread_mutexattr_t attr;
+	return (flags & BOARD_PACKED) ? sizeof(struct ws_archive_pack) : sizeof(struct ws_archive);
+}
 
-	boardp->len = len;
+static size_t
+col_time_size(size_t nloops)
+{
+	return roundup(nloops * sizeof(time_t), SHM_ALIGN);
+}
 
-	/* Shared lock */
-	if (pthread_mutexattr_init(&attr) == -1) {
-		goto error;
+static size_t
+col_data_size(size_t nloops)
+{
+	return roundup(nloops * sizeof(float), SHM_ALIGN);
+}
+
+static size_t
+col_valid_size(size_t nloops)
+{
+	return roundup(divup(nloops, 64) * sizeof(uint64_t), SHM_ALIGN);
+}
+
+static size_t
+shm_cols_size(size_t nloops)
+{
+	size_t colsz = col_data_size(nloops) + col_valid_size(nloops);
+
+	return col_time_size(nloops) + array_size(loop_cols) * colsz;
+}
+
+static size_t
+shm_window_size(long len)
+{
+	return roundup(window_size(len, array_size(loop_cols)), SHM_ALIGN);
+}
+
+/**
+ * Computes the shared board size, for the geometry pointed to by
+ * {@code geom}.
+ *
+ * Each array starts on a cache line boundary, so that history scans do not
+ * share lines with the board header.
+ */
+static size_t
+shm_board_size(const struct shm_geom *geom)
+{
+	size_t i, len;
+
+	len = roundup(sizeof(*boardp), SHM_ALIGN);
+	len += roundup(geom->nloops * loop_size(geom->flags), SHM_ALIGN);
+
+	if (geom->flags & BOARD_COLUMNS) {
+		len += shm_cols_size(geom->nloops);
 	}
-	if (pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == -1) {
-		goto error;
+
+	for (i = 0; i < geom->nwin; i++) {
+		len += shm_window_size(geom->win[i]);
 	}
-	if (pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == -1) {
-		goto error;
+
+	len += geom->nar * ar_size(geom->flags);
+
+	return len;
+}
+
+static uint16_t
+shm_crc(uint16_t crc, size_t v)
+{
+	return ws_crc_ccitt(crc, (const uint8_t *) &v, sizeof(v));
+}
+
+/**
+ * Computes the board header checksum.
+ *
+ * Only the geometry is covered, as the buffers state changes on each update.
+ * The records size is included, so that a layout change in a new release
+ * invalidates the board.
+ */
+static uint16_t
+shm_board_cksum(void)
+{
+	uint16_t crc = 0;
+
+	crc = shm_crc(crc, boardp->magic);
+	crc = shm_crc(crc, boardp->version);
+	crc = shm_crc(crc, boardp->len);
+	crc = shm_crc(crc, boardp->flags);
+	crc = ws_crc_ccitt(crc, (const uint8_t *) boardp->station, sizeof(boardp->station));
+	crc = shm_crc(crc, boardp->loop.off);
+	crc = shm_crc(crc, boardp->loop.sz);
+	crc = shm_crc(crc, boardp->loop.elsz);
+	crc = shm_crc(crc, boardp->cols.off);
+	crc = shm_crc(crc, boardp->cols.ncols);
+	crc = shm_crc(crc, boardp->win.n);
+
+	for (size_t i = 0; i < boardp->win.n && i < WIN_MAX; i++) {
+		crc = shm_crc(crc, boardp->win.off[i]);
+		crc = shm_crc(crc, boardp->win.len[i]);
 	}
 
-	if (pthread_mutex_init(&boardp->mutex, &attr) == -1) {
-		goto error;
+	crc = shm_crc(crc, boardp->ar.off);
+	crc = shm_crc(crc, boardp->ar.sz);
+	crc = shm_crc(crc, boardp->ar.elsz);
+
+	return crc;
+}
+
+static int
+shm_board_check(size_t len, const char *station)
+{
+	if (boardp->magic != BOARD_MAGIC || boardp->version != BOARD_VERSION) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (strncmp(boardp->station, station, sizeof(boardp->station))) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (boardp->len != len || boardp->cksum != shm_board_cksum()) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (boardp->loop.elsz != loop_size(boardp->flags)
+			|| boardp->ar.elsz != ar_size(boardp->flags)
+			|| boardp->cols.ncols != array_size(loop_cols)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static void
+shm_circ_init(struct shm_circ *buf, size_t off, size_t sz, size_t elsz)
+{
+	atomic_init(&buf->seq, 0);
+	buf->off = off;
+	buf->sz = sz;
+	buf->elsz = elsz;
+	buf->nel = 0;
+	buf->idx = 0;
+}
+
+static struct window *
+shm_window(size_t i)
+{
+	return (struct window *) ((char *) boardp + boardp->win.off[i]);
+}
+
+static void
+shm_windows_init(void)
+{
+	size_t i;
+
+	for (i = 0; i < boardp->win.n; i++) {
+		window_init(shm_window(i), boardp->win.len[i], boardp->cols.ncols);
 	}
+}
 
-	(void) pthread_mutexattr_destroy(&attr);
+static int
+shm_board_init(size_t len, const char *station, const struct shm_geom *geom)
+{
+	size_t i;
+
+	boardp->magic = BOARD_MAGIC;
+	boardp->version = BOARD_VERSION;
+	boardp->len = len;
+	boardp->flags = geom->flags;
+	strncpy(boardp->station, station, sizeof(boardp->station));
+	atomic_init(&boardp->update, 0);
 
 	/* Shared arrays */
-	size_t off = sizeof(*boardp);
+	size_t off = roundup(sizeof(*boardp), SHM_ALIGN);
 
-	boardp->loop.off = off;
-	boardp->loop.sz = nloops;
-	boardp->loop.nel = 0;
-	boardp->loop.idx = 0;
+	shm_circ_init(&boardp->loop, off, geom->nloops, loop_size(geom->flags));
+	off += roundup(boardp->loop.sz * boardp->loop.elsz, SHM_ALIGN);
 
-	off += boardp->loop.sz * sizeof(struct ws_loop);
+	boardp->cols.off = 0;
+	boardp->cols.ncols = array_size(loop_cols);
 
-	boardp->ar.off = off;
-	boardp->ar.sz = nar;
-	boardp->ar.nel = 0;
-	boardp->ar.idx = 0;
+	if (geom->flags & BOARD_COLUMNS) {
+		boardp->cols.off = off;
+		off += shm_cols_size(geom->nloops);
+	}
+
+	boardp->win.n = geom->nwin;
+	for (i = 0; i < geom->nwin; i++) {
+		boardp->win.off[i] = off;
+		boardp->win.len[i] = geom->win[i];
+		off += shm_window_size(geom->win[i]);
+	}
 
-	off += boardp->ar.sz * sizeof(struct ws_archive);
+	shm_circ_init(&boardp->ar, off, geom->nar, ar_size(geom->flags));
+	off += boardp->ar.sz * boardp->ar.elsz;
 
 	if (len < off) {
 		errno = ENOMEM;
-		goto error;
+		return -1;
 	}
 
-	return 0;
+	shm_windows_init();
 
-error:
-	errsv = errno;
-	(void) pthread_mutexattr_destroy(&attr);
+	boardp->cksum = shm_board_cksum();
 
-	errno = errsv;
-	return -1;
+	return 0;
 }
 
+/**
+ * Restores the content of a file backed board, after a restart.
+ *
+ * The board is kept if its geometry matches the requested one. A buffer left
+ * in the middle of an update (the writer died) is cleared, along with the
+ * windows for the loop buffer.
+ */
 static int
-shm_board_destroy()
+shm_board_restore(size_t len, const char *station, const struct shm_geom *geom)
 {
-	int ret;
+	struct shm_circ *bufs[] = { &boardp->loop, &boardp->ar };
+	size_t i;
+
+	if (shm_board_check(len, station) == -1) {
+		return -1;
+	}
+	if (boardp->loop.sz != geom->nloops || boardp->ar.sz != geom->nar
+			|| boardp->flags != geom->flags || boardp->win.n != geom->nwin) {
+		errno = EINVAL;
+		return -1;
+	}
+	for (i = 0; i < geom->nwin; i++) {
+		if (boardp->win.len[i] != geom->win[i]) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
 
-	ret = pthread_mutex_destroy(&boardp->mutex);
+	if (atomic_load(&boardp->loop.seq) & 1) {
+		shm_windows_init();
+	}
 
-	return ret;
+	for (i = 0; i < array_size(bufs); i++) {
+		if (atomic_load(&bufs[i]->seq) & 1) {
+			shm_circ_init(bufs[i], bufs[i]->off, bufs[i]->sz, bufs[i]->elsz);
+		}
+	}
+
+	return 0;
 }
 
+/**
+ * Opens the shared board of {@code station}.
+ *
+ * When {@code path} is NULL, the board lives in POSIX shared memory, named
+ * after the station ("/wslog.<station>", or "/wslog" when {@code station} is
+ * NULL), and is released on board_unlink(). Otherwise, the board is mapped to
+ * the specified file, and its content survives restarts. In both cases, the
+ * station name is recorded in the board, and checked by readers.
+ *
+ * The writer uses the O_CREAT flag, followed by the number of loop and archive
+ * elements, the board flags, and the rolling windows (an array of lengths in
+ * seconds, or WIN_DAY, and its size). With BOARD_PACKED, records are stored
+ * in their packed form (see ws_loop_pack()), at the cost of precision. With
+ * BOARD_COLUMNS, loop history is also kept in columns, for board_aggr().
+ * Readers map the board read-only.
+ */
 ssize_t
-board_open(int oflag, /* args */ ...)
+board_open(const char *station, const char *path, int oflag, /* args */ ...)
 {
 	int errsv;
-	int shmfd, shmlen;
-	size_t nloops, nar;
+	int shmfd, prot;
+	size_t shmlen;
+	struct shm_geom geom;
+	struct stat sbuf;
 	va_list ap;
 
 	shmfd = -1;
+	shmlen = 0;
 	shmflag = oflag;
-	nloops = 0;
-	nar = 0;
+	shmfile = (path != NULL);
+	restored = 0;
+	memset(&geom, 0, sizeof(geom));
 
-	/* Create shared memory */
-	shmfd = shm_open(SHM_NAME, O_RDWR|oflag, S_IRUSR|S_IWUSR);
-	if (shmfd == -1) {
+	/* Station name */
+	if (station == NULL) {
+		station = "";
+	}
+	if (BOARD_STATION <= strlen(station) || strchr(station, '/') != NULL) {
+		errno = EINVAL;
 		return -1;
 	}
 
+	if (*station == 0) {
+		strcpy(shmname, SHM_NAME);
+	} else {
+		snprintf(shmname, sizeof(shmname), "%s.%s", SHM_NAME, station);
+	}
+
 	if (oflag & O_CREAT) {
+		size_t i;
+
 		va_start(ap, oflag);
-		nloops = va_arg(ap, size_t);
-		nar = va_arg(ap, size_t);
+		geom.nloops = va_arg(ap, size_t);
+		geom.nar = va_arg(ap, size_t);
+		geom.flags = va_arg(ap, int);
+		geom.win = va_arg(ap, const long *);
+		geom.nwin = va_arg(ap, size_t);
 		va_end(ap);
 
-		shmlen = shm_board_size(nloops, nar);
-
-		if (ftruncate(shmfd, shmlen) == -1) {
-			goto error;
+		if (geom.nloops == 0 || geom.nar == 0 || WIN_MAX < geom.nwin) {
+			errno = EINVAL;
+			return -1;
+		}
+		for (i = 0; i < geom.nwin; i++) {
+			if (geom.win[i] < 0) {
+				errno = EINVAL;
+				return -1;
+			}
 		}
+
+		oflag |= O_RDWR;
+		prot = PROT_READ|PROT_WRITE;
+	} else {
+		oflag |= O_RDONLY;
+		prot = PROT_READ;
+	}
+
+	/* Create shared memory */
+	if (shmfile) {
+		shmfd = open(path, oflag, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
 	} else {
-		struct stat sbuf;
+		shmfd = shm_open(shmname, oflag, S_IRUSR|S_IWUSR);
+	}
+	if (shmfd == -1) {
+		return -1;
+	}
+
+	if (fstat(shmfd, &sbuf) == -1) {
+		goto error;
+	}
+
+	if (oflag & O_CREAT) {
+		shmlen = shm_board_size(&geom);
 
-		if (fstat(shmfd, &sbuf) == -1) {
+		if (shmfile && (size_t) sbuf.st_size == shmlen) {
+			restored = 1;
+		} else if (ftruncate(shmfd, shmlen) == -1) {
 			goto error;
 		}
-
+	} else {
 		shmlen = sbuf.st_size;
 	}
 
-	shmbufp = mmap(NULL, shmlen, PROT_READ|PROT_WRITE, MAP_SHARED, shmfd, 0);
+	shmbufp = mmap(NULL, shmlen, prot, MAP_SHARED, shmfd, 0);
 	if (shmbufp == MAP_FAILED) {
 		goto error;
 	}
@@ -170,7 +588,17 @@ board_open(int oflag, /* args */ ...)
 
 	/* Initialize shared_memory content */
 	if (oflag & O_CREAT) {
-		if (shm_board_init(shmlen, nloops, nar) == -1) {
+		if (restored && shm_board_restore(shmlen, station, &geom) == -1) {
+			restored = 0;
+		}
+
+		if (!restored && shm_board_init(shmlen, station, &geom) == -1) {
+			goto error;
+		}
+
+		memset(&boardp->stats, 0, sizeof(boardp->stats));
+	} else {
+		if (shm_board_check(shmlen, station) == -1) {
 			goto error;
 		}
 	}
@@ -183,7 +611,8 @@ error:
 		(void) close(shmfd);
 	}
 	if (shmbufp != MAP_FAILED) {
-		(void) board_unlink();
+		(void) munmap(shmbufp, shmlen);
+		shmbufp = MAP_FAILED;
 	}
 
 	errno = errsv;
@@ -199,8 +628,9 @@ board_unlink()
 	ret = 0;
 	shmlen = boardp->len;
 
-	if (shmflag & O_CREAT) {
-		if (shm_board_destroy() == -1) {
+	/* Flush file backed board */
+	if (shmfile && (shmflag & O_CREAT)) {
+		if (msync(shmbufp, shmlen, MS_SYNC) == -1) {
 			ret = -1;
 		}
 	}
@@ -209,43 +639,25 @@ board_unlink()
 	if (munmap(shmbufp, shmlen) == -1) {
 		ret = -1;
 	}
-	if (shmflag & O_CREAT) {
-		if (shm_unlink(SHM_NAME) == -1) {
+	if (!shmfile && (shmflag & O_CREAT)) {
+		if (shm_unlink(shmname) == -1) {
 			ret = -1;
 		}
 	}
 
-	return ret;
-}
-
-int
-board_lock(void)
-{
-	int ret;
-
-	ret = pthread_mutex_lock(&boardp->mutex);
-	if (ret == -1) {
-		/* Owner died with lock */
-		if (errno == EOWNERDEAD) {
-			if (shmflag & O_CREAT) {
-				/* Unrecoverable error */
-			} else {
-				ret = pthread_mutex_consistent(&boardp->mutex);
-			}
-		}
-	}
+	shmbufp = MAP_FAILED;
 
 	return ret;
 }
 
+/**
+ * Returns 1 if the board content was restored by the last board_open(), and
+ * 0 otherwise.
+ */
 int
-board_unlock(void)
+board_restored(void)
 {
-	int ret;
-
-	ret = pthread_mutex_unlock(&boardp->mutex);
-
-	return ret;
+	return restored;
 }
 
 /**
@@ -284,46 +696,1274 @@ shm_buf_index(const struct shm_circ *buf, size_t i)
 	return i;
 }
 
-void
-board_push(const struct ws_loop *p)
+/**
+ * Returns the address of the i-th element of the circular buffer pointed to
+ * by {@code buf}, or NULL if out of bounds.
+ */
+static void *
+shm_buf_at(const struct shm_circ *buf, size_t i, size_t elsz)
 {
-	shm_buf_inc(&boardp->loop);
-	memcpy(board_peek(0), p, sizeof(*p));
+	void *p;
+
+	if (buf->nel <= i) {
+		p = NULL;
+	} else {
+		i = shm_buf_index(buf, i);
+
+		if (buf->sz <= i) {
+			/* Inconsistent read, see shm_buf_get() */
+			p = NULL;
+		} else {
+			p = (char *) boardp + buf->off + i * elsz;
+		}
+	}
+
+	return p;
 }
 
-void
-board_push_ar(const struct ws_archive *p)
+static void
+shm_write_begin(struct shm_circ *buf)
 {
-	shm_buf_inc(&boardp->ar);
-	memcpy(board_peek_ar(0), p, sizeof(*p));
+	unsigned int seq;
+
+	seq = atomic_load_explicit(&buf->seq, memory_order_relaxed);
+	atomic_store_explicit(&buf->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
 }
 
-struct ws_loop *
-board_peek(size_t i)
+static void
+shm_write_end(struct shm_circ *buf)
 {
-	struct ws_loop *p;
+	unsigned int seq;
 
-	if (boardp->loop.nel <= i) {
-		p = NULL;
-	} else {
-		i = shm_buf_index(&boardp->loop, i);
-		p = &((struct ws_loop *) ((char *) boardp + boardp->loop.off))[i];
-	}
+	seq = atomic_load_explicit(&buf->seq, memory_order_relaxed);
+	atomic_store_explicit(&buf->seq, seq + 1, memory_order_release);
+}
 
-	return p;
+static void
+shm_buf_push(struct shm_circ *buf, const void *p, size_t elsz)
+{
+	shm_write_begin(buf);
+
+	shm_buf_inc(buf);
+	memcpy(shm_buf_at(buf, 0, elsz), p, elsz);
+
+	shm_write_end(buf);
+}
+
+static time_t *
+col_time(void)
+{
+	return (time_t *) ((char *) boardp + boardp->cols.off);
 }
 
-struct ws_archive *
-board_peek_ar(size_t i)
+static float *
+col_data(size_t c)
 {
-	struct ws_archive *p;
+	size_t nloops = boardp->loop.sz;
+	char *p = (char *) col_time() + col_time_size(nloops);
 
-	if (boardp->ar.nel <= i) {
-		p = NULL;
-	} else {
-		i = shm_buf_index(&boardp->ar, i);
-		p = &((struct ws_archive *) ((char *) boardp + boardp->ar.off))[i];
+	return (float *) (p + c * (col_data_size(nloops) + col_valid_size(nloops)));
+}
+
+static uint64_t *
+col_valid(size_t c)
+{
+	return (uint64_t *) ((char *) col_data(c) + col_data_size(boardp->loop.sz));
+}
+
+/**
+ * Updates the loop columns at index {@code i}. The {@code v} array holds the
+ * value of each column, valid when the matching bit of {@code mask} is set.
+ */
+static void
+shm_cols_put(size_t i, time_t t, const double *v, uint32_t mask)
+{
+	size_t c;
+	uint64_t bit = (uint64_t) 1 << (i % 64);
+
+	col_time()[i] = t;
+
+	for (c = 0; c < array_size(loop_cols); c++) {
+		uint64_t *valid = col_valid(c) + i / 64;
+
+		if (mask & (1U << c)) {
+			col_data(c)[i] = v[c];
+			*valid |= bit;
+		} else {
+			*valid &= ~bit;
+		}
 	}
+}
 
-	return p;
+/**
+ * Copy the i-th element of the circular buffer pointed to by {@code buf}.
+ *
+ * The buffer is read without locking. The copy is retried as long as the
+ * writer updated the buffer in the meantime.
+ */
+static int
+shm_buf_get(const struct shm_circ *buf, size_t i, void *p, size_t elsz)
+{
+	int retry;
+
+	for (retry = 0; retry < SEQ_RETRY; retry++) {
+		const void *src;
+		unsigned int seq;
+
+		seq = atomic_load_explicit(&buf->seq, memory_order_acquire);
+
+		if (seq & 1) {
+			/* Write in progress */
+			(void) sched_yield();
+		} else {
+			src = shm_buf_at(buf, i, elsz);
+
+			if (src != NULL) {
+				memcpy(p, src, elsz);
+			}
+
+			atomic_thread_fence(memory_order_acquire);
+
+			if (seq == atomic_load_explicit(&buf->seq, memory_order_relaxed)) {
+				if (src == NULL) {
+					errno = ENODATA;
+					return -1;
+				}
+
+				return 0;
+			}
+		}
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+static time_t
+loop_time(const void *p)
+{
+	return ((const struct ws_loop *) p)->time.tv_sec;
+}
+
+static time_t
+ar_time(const void *p)
+{
+	return ((const struct ws_archive *) p)->time;
+}
+
+static time_t
+loop_pack_time(const void *p)
+{
+	return ((const struct ws_loop_pack *) p)->time / 1000;
+}
+
+static time_t
+ar_pack_time(const void *p)
+{
+	return ((const struct ws_archive_pack *) p)->time;
+}
+
+static time_t
+col_time_of(const void *p)
+{
+	return *(const time_t *) p;
+}
+
+/**
+ * Computes the array index of the i-th most recent element, for a circular
+ * buffer holding {@code nel} elements, the most recent one at {@code idx}.
+ */
+static size_t
+shm_buf_pos(size_t nel, size_t idx, size_t i)
+{
+	return (i <= idx) ? idx - i : nel - (i - idx);
+}
+
+/**
+ * Returns the number of most recent elements newer than {@code from}, up to
+ * {@code max}, using a binary search (elements are time ordered).
+ */
+static size_t
+shm_buf_newer(const char *base, size_t nel, size_t idx, size_t max,
+		size_t elsz, time_t from, time_t (*timeof)(const void *))
+{
+	size_t lo, hi;
+
+	lo = 0;
+	hi = min(nel, max);
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (from < timeof(base + shm_buf_pos(nel, idx, mid) * elsz)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+/**
+ * Copy the most recent elements of the circular buffer pointed to by
+ * {@code buf}, newer than {@code from}, in chronological order.
+ *
+ * At most {@code max} elements are copied to {@code dst}. The elements span
+ * at most two contiguous segments of the buffer, which are copied within a
+ * single read section. The function returns the number of elements copied.
+ */
+static ssize_t
+shm_buf_copy(const struct shm_circ *buf, void *dst, size_t max, size_t elsz,
+		time_t from, time_t (*timeof)(const void *))
+{
+	int retry;
+
+	for (retry = 0; retry < SEQ_RETRY; retry++) {
+		unsigned int seq;
+		size_t nel, idx, n;
+
+		seq = atomic_load_explicit(&buf->seq, memory_order_acquire);
+
+		if (seq & 1) {
+			/* Write in progress */
+			(void) sched_yield();
+			continue;
+		}
+
+		nel = buf->nel;
+		idx = buf->idx;
+		n = 0;
+
+		if (nel <= buf->sz && (idx < nel || nel == 0)) {
+			size_t first;
+			const char *base = (const char *) boardp + buf->off;
+
+			n = shm_buf_newer(base, nel, idx, max, elsz, from, timeof);
+
+			/* Oldest first, up to the end of the array, then wrap */
+			if (n > 0) {
+				first = shm_buf_pos(nel, idx, n - 1);
+
+				if (first <= idx) {
+					memcpy(dst, base + first * elsz, n * elsz);
+				} else {
+					size_t k = nel - first;
+
+					memcpy(dst, base + first * elsz, k * elsz);
+					memcpy((char *) dst + k * elsz, base, (idx + 1) * elsz);
+				}
+			}
+		}
+
+		atomic_thread_fence(memory_order_acquire);
+
+		if (seq == atomic_load_explicit(&buf->seq, memory_order_relaxed)) {
+			return n;
+		}
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+static long
+futex(atomic_uint *uaddr, int op, unsigned int val, const struct timespec *ts)
+{
+	return syscall(SYS_futex, uaddr, op, val, ts, NULL, 0);
+}
+
+/**
+ * Notifies board readers blocked in board_wait().
+ */
+static void
+shm_board_notify(void)
+{
+	atomic_fetch_add_explicit(&boardp->update, 1, memory_order_release);
+	(void) futex(&boardp->update, FUTEX_WAKE, INT_MAX, NULL);
+}
+
+void
+board_push(const struct ws_loop *p)
+{
+	size_t i;
+	uint32_t mask;
+	double v[array_size(loop_cols)];
+	struct win_wind wind = { 0, 0, 0 };
+	struct shm_circ *buf = &boardp->loop;
+
+	/* Loop fields, in columns order */
+	mask = 0;
+
+	for (i = 0; i < array_size(loop_cols); i++) {
+		if (loop_cols[i].get(p, &v[i]) == 0) {
+			mask |= (1U << i);
+		}
+	}
+	if (WF_ISSET(p->wl_mask, WF_WIND_SPEED|WF_WIND_DIR)) {
+		win_wind_init(&wind, p->wind_speed, p->wind_dir);
+	}
+
+	shm_write_begin(buf);
+
+	shm_buf_inc(buf);
+
+	if (boardp->flags & BOARD_PACKED) {
+		ws_loop_pack(shm_buf_at(buf, 0, buf->elsz), p);
+	} else {
+		memcpy(shm_buf_at(buf, 0, buf->elsz), p, sizeof(*p));
+	}
+
+	if (boardp->flags & BOARD_COLUMNS) {
+		shm_cols_put(buf->idx, p->time.tv_sec, v, mask);
+	}
+
+	for (i = 0; i < boardp->win.n; i++) {
+		window_push(shm_window(i), p->time.tv_sec, v, mask, &wind);
+	}
+
+	shm_write_end(buf);
+
+	shm_board_notify();
+}
+
+/**
+ * Expires the rolling windows at time {@code t}, while no loop is pushed.
+ * Shall be called by the loop writer only.
+ */
+void
+board_window_expire(time_t t)
+{
+	size_t i;
+	struct shm_circ *buf = &boardp->loop;
+
+	shm_write_begin(buf);
+
+	for (i = 0; i < boardp->win.n; i++) {
+		window_expire(shm_window(i), t);
+	}
+
+	shm_write_end(buf);
+}
+
+void
+board_push_ar(const struct ws_archive *p)
+{
+	if (boardp->flags & BOARD_PACKED) {
+		struct ws_archive_pack pbuf;
+
+		ws_archive_pack(&pbuf, p);
+		shm_buf_push(&boardp->ar, &pbuf, sizeof(pbuf));
+	} else {
+		shm_buf_push(&boardp->ar, p, sizeof(*p));
+	}
+
+	shm_board_notify();
+}
+
+/**
+ * Copy loop elements newer than {@code from} into {@code dst}, oldest first.
+ *
+ * At most {@code max} of the most recent elements are copied. The function
+ * returns the number of elements copied, or -1 on error.
+ */
+ssize_t
+board_copy_loops(struct ws_loop *dst, time_t from, size_t max)
+{
+	ssize_t i, n;
+
+	if (!(boardp->flags & BOARD_PACKED)) {
+		return shm_buf_copy(&boardp->loop, dst, max, sizeof(*dst), from, loop_time);
+	}
+
+	/*
+	 * Packed records are copied at the beginning of dst, then decoded in
+	 * place, from the last one, as they are smaller.
+	 */
+	n = shm_buf_copy(&boardp->loop, dst, max, sizeof(struct ws_loop_pack),
+			from, loop_pack_time);
+
+	for (i = n - 1; i >= 0; i--) {
+		struct ws_loop_pack pbuf;
+
+		memcpy(&pbuf, (char *) dst + i * sizeof(pbuf), sizeof(pbuf));
+		ws_loop_unpack(&dst[i], &pbuf);
+	}
+
+	return n;
+}
+
+/**
+ * Copy archive elements newer than {@code from} into {@code dst}, oldest
+ * first.
+ *
+ * See board_copy_loops().
+ */
+ssize_t
+board_copy_ar(struct ws_archive *dst, time_t from, size_t max)
+{
+	ssize_t i, n;
+
+	if (!(boardp->flags & BOARD_PACKED)) {
+		return shm_buf_copy(&boardp->ar, dst, max, sizeof(*dst), from, ar_time);
+	}
+
+	/* See board_copy_loops() */
+	n = shm_buf_copy(&boardp->ar, dst, max, sizeof(struct ws_archive_pack),
+			from, ar_pack_time);
+
+	for (i = n - 1; i >= 0; i--) {
+		struct ws_archive_pack pbuf;
+
+		memcpy(&pbuf, (char *) dst + i * sizeof(pbuf), sizeof(pbuf));
+		ws_archive_unpack(&dst[i], &pbuf);
+	}
+
+	return n;
+}
+
+struct col_acc
+{
+	size_t count;			/* Number of values */
+	double sum;			/* Sum of values */
+	float min;			/* Lowest value */
+	float max;			/* Highest value */
+};
+
+/**
+ * Accumulates {@code n} contiguous values (n > 0).
+ */
+static void
+col_acc_dense(struct col_acc *acc, const float *col, size_t n)
+{
+	size_t i;
+	double sum = 0;
+	float lo = col[0];
+	float hi = col[0];
+
+	for (i = 0; i < n; i++) {
+		sum += col[i];
+		lo = (col[i] < lo) ? col[i] : lo;
+		hi = (hi < col[i]) ? col[i] : hi;
+	}
+
+	if (acc->count == 0 || lo < acc->min) {
+		acc->min = lo;
+	}
+	if (acc->count == 0 || acc->max < hi) {
+		acc->max = hi;
+	}
+
+	acc->sum += sum;
+	acc->count += n;
+}
+
+/**
+ * Accumulates the valid values of {@code col}, from index {@code lo} to
+ * {@code hi} (excluded).
+ *
+ * Runs of valid values (full bitmap words) are accumulated without testing
+ * each bit.
+ */
+static void
+col_scan(struct col_acc *acc, const float *col, const uint64_t *valid,
+		size_t lo, size_t hi)
+{
+	size_t k = lo;
+
+	while (k < hi) {
+		size_t end = min(hi, roundup(k + 1, 64));
+		uint64_t bits = valid[k / 64];
+
+		if (bits == UINT64_MAX) {
+			while (end < hi && valid[end / 64] == UINT64_MAX) {
+				end = min(hi, end + 64);
+			}
+
+			col_acc_dense(acc, col + k, end - k);
+		} else {
+			for (; k < end; k++) {
+				if ((bits >> (k % 64)) & 1) {
+					col_acc_dense(acc, col + k, 1);
+				}
+			}
+		}
+
+		k = end;
+	}
+}
+
+static int
+col_acc_finish(const struct col_acc *acc, enum aggr_type type, double *v)
+{
+	if (type == AGGR_COUNT) {
+		*v = acc->count;
+		return 0;
+	}
+	if (acc->count == 0) {
+		errno = ENODATA;
+		return -1;
+	}
+
+	switch (type) {
+	case AGGR_SUM:
+		*v = acc->sum;
+		break;
+	case AGGR_AVG:
+		*v = acc->sum / acc->count;
+		break;
+	case AGGR_MIN:
+		*v = acc->min;
+		break;
+	case AGGR_MAX:
+		*v = acc->max;
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Aggregates column {@code c} from the loop records, when the board has no
+ * columns. See board_aggr().
+ */
+static int
+shm_loop_aggr(size_t c, enum aggr_type type, time_t from, time_t to, double *v)
+{
+	int retry;
+	time_t (*timeof)(const void *);
+	const struct shm_circ *buf = &boardp->loop;
+	const char *base = (const char *) boardp + buf->off;
+
+	timeof = (boardp->flags & BOARD_PACKED) ? loop_pack_time : loop_time;
+
+	for (retry = 0; retry < SEQ_RETRY; retry++) {
+		unsigned int seq;
+		size_t nel, idx;
+		struct col_acc acc = { 0, 0, 0, 0 };
+
+		seq = atomic_load_explicit(&buf->seq, memory_order_acquire);
+
+		if (seq & 1) {
+			/* Write in progress */
+			(void) sched_yield();
+			continue;
+		}
+
+		nel = buf->nel;
+		idx = buf->idx;
+
+		if (nel <= buf->sz && idx < nel) {
+			size_t k, lo, hi;
+
+			/* Window elements, from age lo to hi (excluded) */
+			lo = shm_buf_newer(base, nel, idx, nel, buf->elsz, to, timeof);
+			hi = shm_buf_newer(base, nel, idx, nel, buf->elsz, from, timeof);
+
+			for (k = lo; k < hi; k++) {
+				double d;
+				float f;
+				struct ws_loop l;
+				const char *p = base + shm_buf_pos(nel, idx, k) * buf->elsz;
+
+				if (boardp->flags & BOARD_PACKED) {
+					struct ws_loop_pack pbuf;
+
+					memcpy(&pbuf, p, sizeof(pbuf));
+					ws_loop_unpack(&l, &pbuf);
+				} else {
+					memcpy(&l, p, sizeof(l));
+				}
+
+				/* Same precision as columns */
+				if (loop_cols[c].get(&l, &d) == 0) {
+					f = d;
+					col_acc_dense(&acc, &f, 1);
+				}
+			}
+		}
+
+		atomic_thread_fence(memory_order_acquire);
+
+		if (seq == atomic_load_explicit(&buf->seq, memory_order_relaxed)) {
+			return col_acc_finish(&acc, type, v);
+		}
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+/**
+ * Aggregates the loop values of {@code field} (one of WS_*), sampled after
+ * {@code from} and up to {@code to}.
+ *
+ * The {@code type} argument is one of AGGR_SUM, AGGR_AVG, AGGR_MIN, AGGR_MAX
+ * or AGGR_COUNT. Directions are averaged as plain values. With
+ * BOARD_COLUMNS, only the field column is scanned; otherwise, the loop
+ * records are.
+ *
+ * If no value is available, -1 is returned and errno is set to ENODATA. Fields
+ * not found in loop data set errno to EINVAL.
+ */
+int
+board_aggr(int field, enum aggr_type type, time_t from, time_t to, double *v)
+{
+	size_t c;
+	int retry;
+	const char *times;
+	const float *data;
+	const uint64_t *valid;
+	const struct shm_circ *buf = &boardp->loop;
+
+	for (c = 0; c < array_size(loop_cols); c++) {
+		if (loop_cols[c].field == field) {
+			break;
+		}
+	}
+	if (c == array_size(loop_cols)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!(boardp->flags & BOARD_COLUMNS)) {
+		return shm_loop_aggr(c, type, from, to, v);
+	}
+
+	times = (const char *) col_time();
+	data = col_data(c);
+	valid = col_valid(c);
+
+	for (retry = 0; retry < SEQ_RETRY; retry++) {
+		unsigned int seq;
+		size_t nel, idx;
+		struct col_acc acc = { 0, 0, 0, 0 };
+
+		seq = atomic_load_explicit(&buf->seq, memory_order_acquire);
+
+		if (seq & 1) {
+			/* Write in progress */
+			(void) sched_yield();
+			continue;
+		}
+
+		nel = buf->nel;
+		idx = buf->idx;
+
+		if (nel <= buf->sz && idx < nel) {
+			size_t lo, hi;
+
+			/* Window elements, from age lo to hi (excluded) */
+			lo = shm_buf_newer(times, nel, idx, nel, sizeof(time_t), to, col_time_of);
+			hi = shm_buf_newer(times, nel, idx, nel, sizeof(time_t), from, col_time_of);
+
+			if (lo < hi) {
+				size_t newest = shm_buf_pos(nel, idx, lo);
+				size_t oldest = shm_buf_pos(nel, idx, hi - 1);
+
+				if (oldest <= newest) {
+					col_scan(&acc, data, valid, oldest, newest + 1);
+				} else {
+					col_scan(&acc, data, valid, oldest, nel);
+					col_scan(&acc, data, valid, 0, newest + 1);
+				}
+			}
+		}
+
+		atomic_thread_fence(memory_order_acquire);
+
+		if (seq == atomic_load_explicit(&buf->seq, memory_order_relaxed)) {
+			return col_acc_finish(&acc, type, v);
+		}
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+/**
+ * Copies {@code len} bytes at {@code src}, updated within the write section
+ * of the buffer pointed to by {@code buf}.
+ */
+static int
+shm_seq_copy(const struct shm_circ *buf, void *dst, const void *src, size_t len)
+{
+	int retry;
+
+	for (retry = 0; retry < SEQ_RETRY; retry++) {
+		unsigned int seq;
+
+		seq = atomic_load_explicit(&buf->seq, memory_order_acquire);
+
+		if (seq & 1) {
+			/* Write in progress */
+			(void) sched_yield();
+		} else {
+			memcpy(dst, src, len);
+
+			atomic_thread_fence(memory_order_acquire);
+
+			if (seq == atomic_load_explicit(&buf->seq, memory_order_relaxed)) {
+				return 0;
+			}
+		}
+	}
+
+	errno = EAGAIN;
+	return -1;
+}
+
+static struct window *
+shm_window_find(long len)
+{
+	size_t i;
+
+	for (i = 0; i < boardp->win.n; i++) {
+		if (boardp->win.len[i] == len) {
+			return shm_window(i);
+		}
+	}
+
+	errno = ENOENT;
+	return NULL;
+}
+
+/**
+ * Returns the statistics of {@code field} (one of WS_*), over the rolling
+ * window of length {@code len} (in seconds, or WIN_DAY).
+ *
+ * Windows are maintained by board_push(), and cover the most recent loop
+ * elements. If the window does not exist, -1 is returned and errno is set to
+ * ENOENT. If no value is available, errno is set to ENODATA.
+ */
+int
+board_window(long len, int field, struct win_stat *p)
+{
+	size_t c;
+	const struct window *w;
+
+	for (c = 0; c < array_size(loop_cols); c++) {
+		if (loop_cols[c].field == field) {
+			break;
+		}
+	}
+	if (c == array_size(loop_cols)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if ((w = shm_window_find(len)) == NULL) {
+		return -1;
+	}
+	if (shm_seq_copy(&boardp->loop, p, &w->stat[c], sizeof(*p)) == -1) {
+		return -1;
+	}
+	if (p->count == 0) {
+		errno = ENODATA;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the mean wind vector, over the rolling window of length
+ * {@code len}.
+ *
+ * See board_window().
+ */
+int
+board_window_wind(long len, double *speed, double *dir)
+{
+	struct win_wind wind;
+	const struct window *w;
+
+	if ((w = shm_window_find(len)) == NULL) {
+		return -1;
+	}
+	if (shm_seq_copy(&boardp->loop, &wind, &w->wind, sizeof(wind)) == -1) {
+		return -1;
+	}
+
+	return win_wind_mean(&wind, speed, dir);
+}
+
+/**
+ * Returns the capacity of the loop and archive buffers.
+ */
+void
+board_size(size_t *nloops, size_t *nar)
+{
+	*nloops = boardp->loop.sz;
+	*nar = boardp->ar.sz;
+}
+
+/**
+ * Returns the approximate board memory taken by each loop element, with
+ * board flags {@code flags}: the record, and its columns with
+ * BOARD_COLUMNS.
+ */
+size_t
+board_loop_size(int flags)
+{
+	size_t sz = loop_size(flags);
+
+	if (flags & BOARD_COLUMNS) {
+		sz += sizeof(time_t) + array_size(loop_cols) * sizeof(float);
+	}
+
+	return sz;
+}
+
+/**
+ * Registers service {@code srv} (from 0 to BOARD_SRV_MAX - 1), named
+ * {@code name}, in the board counters.
+ */
+void
+board_stat_register(size_t srv, const char *name)
+{
+	struct shm_stats *st = &boardp->stats;
+
+	if (srv < BOARD_SRV_MAX) {
+		strncpy(st->srv[srv].name, name, BOARD_SRV_NAME - 1);
+
+		if (atomic_load_explicit(&st->nsrv, memory_order_relaxed) <= srv) {
+			atomic_store_explicit(&st->nsrv, srv + 1, memory_order_release);
+		}
+	}
+}
+
+static void
+shm_hist_put(struct shm_hist *p, unsigned long us)
+{
+	int i;
+	unsigned long max;
+
+	/* Bucket index: floor(log2(us)) */
+	i = (us < 2) ? 0 : (int) (8 * sizeof(us)) - 1 - __builtin_clzl(us);
+	if (BOARD_HIST_BUCKETS <= i) {
+		i = BOARD_HIST_BUCKETS - 1;
+	}
+
+	atomic_fetch_add_explicit(&p->bucket[i], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&p->count, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&p->sum, us, memory_order_relaxed);
+
+	/* Services update concurrently: retry until max is at least us */
+	max = atomic_load_explicit(&p->max, memory_order_relaxed);
+	while (max < us && !atomic_compare_exchange_weak_explicit(&p->max,
+			&max, us, memory_order_relaxed, memory_order_relaxed)) {
+	}
+}
+
+static void
+shm_hist_add(struct shm_hist *p, const struct timespec *start)
+{
+	struct timespec now;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+	shm_hist_put(p, (now.tv_sec - start->tv_sec) * 1000000
+			+ (now.tv_nsec - start->tv_nsec) / 1000);
+}
+
+/**
+ * Accounts an event handled by service {@code srv}, with result {@code ret}
+ * (-1 on failure), started at {@code start} (monotonic clock).
+ */
+void
+board_stat_event(size_t srv, int ret, const struct timespec *start)
+{
+	struct shm_srv *p;
+
+	if (BOARD_SRV_MAX <= srv) {
+		return;
+	}
+
+	p = &boardp->stats.srv[srv];
+
+	atomic_fetch_add_explicit(&p->events, 1, memory_order_relaxed);
+
+	if (ret == -1) {
+		atomic_fetch_add_explicit(&p->failures, 1, memory_order_relaxed);
+	} else {
+		atomic_store_explicit(&p->last_success, time(NULL), memory_order_relaxed);
+	}
+
+	shm_hist_add(&p->latency, start);
+}
+
+/**
+ * Accounts the time spent in queue by an event of service {@code srv},
+ * notified at {@code queued} (monotonic clock), when its handling starts.
+ */
+void
+board_stat_wait(size_t srv, const struct timespec *queued)
+{
+	if (srv < BOARD_SRV_MAX) {
+		shm_hist_add(&boardp->stats.srv[srv].wait, queued);
+	}
+}
+
+/**
+ * Accounts the age of a sample handled by service {@code srv}, whose
+ * acquisition started at {@code origin} (monotonic clock). This is the
+ * end-to-end latency of the sample, from the driver to the service.
+ */
+void
+board_stat_age(size_t srv, const struct timespec *origin)
+{
+	if (srv < BOARD_SRV_MAX) {
+		shm_hist_add(&boardp->stats.srv[srv].age, origin);
+	}
+}
+
+/**
+ * Accounts a notification to service {@code srv}, which could not be
+ * delivered.
+ */
+void
+board_stat_drop(size_t srv)
+{
+	if (srv < BOARD_SRV_MAX) {
+		atomic_fetch_add_explicit(&boardp->stats.srv[srv].dropped, 1, memory_order_relaxed);
+	}
+}
+
+/**
+ * Accounts a notification to service {@code srv}, merged with a pending one.
+ */
+void
+board_stat_coalesce(size_t srv)
+{
+	if (srv < BOARD_SRV_MAX) {
+		atomic_fetch_add_explicit(&boardp->stats.srv[srv].coalesced, 1, memory_order_relaxed);
+	}
+}
+
+/**
+ * Accounts an event skipped by service {@code srv}, while backing off.
+ */
+void
+board_stat_skip(size_t srv)
+{
+	if (srv < BOARD_SRV_MAX) {
+		atomic_fetch_add_explicit(&boardp->stats.srv[srv].skipped, 1, memory_order_relaxed);
+	}
+}
+
+/**
+ * Accounts a restart of service {@code srv} by the supervisor.
+ */
+void
+board_stat_restart(size_t srv)
+{
+	if (srv < BOARD_SRV_MAX) {
+		atomic_fetch_add_explicit(&boardp->stats.srv[srv].restarts, 1, memory_order_relaxed);
+	}
+}
+
+/**
+ * Sets the health of service {@code srv}.
+ */
+void
+board_stat_health(size_t srv, enum board_health health)
+{
+	if (srv < BOARD_SRV_MAX) {
+		atomic_store_explicit(&boardp->stats.srv[srv].health, health, memory_order_relaxed);
+	}
+}
+
+/**
+ * Accounts the latency of the operation {@code id}, started at
+ * {@code start} (monotonic clock).
+ */
+void
+board_stat_time(enum board_hist_id id, const struct timespec *start)
+{
+	shm_hist_add(&boardp->stats.hist[id], start);
+}
+
+/**
+ * Accounts the sample {@code us} (in microseconds) of the measure {@code id}.
+ */
+void
+board_stat_sample(enum board_hist_id id, unsigned long us)
+{
+	shm_hist_put(&boardp->stats.hist[id], us);
+}
+
+/**
+ * Updates the progress of the archive backfill.
+ */
+void
+board_stat_backfill(enum board_backfill_state state, time_t from,
+		time_t current, unsigned long records)
+{
+	struct shm_backfill *p = &boardp->stats.backfill;
+
+	atomic_store_explicit(&p->from, from, memory_order_relaxed);
+	atomic_store_explicit(&p->current, current, memory_order_relaxed);
+	atomic_store_explicit(&p->records, records, memory_order_relaxed);
+	atomic_store_explicit(&p->state, state, memory_order_relaxed);
+}
+
+/**
+ * Accounts records handled by the database writer: {@code saved} records
+ * were saved, and {@code lost} ones were not.
+ */
+void
+board_stat_writer(unsigned long saved, unsigned long lost)
+{
+	struct shm_writer *p = &boardp->stats.writer;
+
+	atomic_fetch_add_explicit(&p->saved, saved, memory_order_relaxed);
+	atomic_fetch_add_explicit(&p->lost, lost, memory_order_relaxed);
+}
+
+/**
+ * Updates the logging counters.
+ */
+void
+board_stat_log(unsigned long logged, unsigned long repeated,
+		unsigned long dropped)
+{
+	struct shm_log *p = &boardp->stats.log;
+
+	atomic_store_explicit(&p->logged, logged, memory_order_relaxed);
+	atomic_store_explicit(&p->repeated, repeated, memory_order_relaxed);
+	atomic_store_explicit(&p->dropped, dropped, memory_order_relaxed);
+}
+
+/**
+ * Updates the daemon resident memory, in kB.
+ */
+void
+board_stat_memory(long rss, long peak)
+{
+	struct shm_memory *p = &boardp->stats.memory;
+
+	atomic_store_explicit(&p->rss, rss, memory_order_relaxed);
+	atomic_store_explicit(&p->peak, peak, memory_order_relaxed);
+}
+
+static void
+shm_hist_load(struct board_hist *dst, const struct shm_hist *src)
+{
+	size_t i;
+
+	dst->count = atomic_load_explicit(&src->count, memory_order_relaxed);
+	dst->sum = atomic_load_explicit(&src->sum, memory_order_relaxed);
+	dst->max = atomic_load_explicit(&src->max, memory_order_relaxed);
+
+	for (i = 0; i < BOARD_HIST_BUCKETS; i++) {
+		dst->bucket[i] = atomic_load_explicit(&src->bucket[i], memory_order_relaxed);
+	}
+}
+
+/**
+ * Takes a snapshot of the board counters.
+ *
+ * Counters are read one by one, and may not be consistent with each other.
+ */
+int
+board_stats(struct board_stats *p)
+{
+	size_t i;
+	const struct shm_stats *st = &boardp->stats;
+
+	memset(p, 0, sizeof(*p));
+
+	p->nsrv = atomic_load_explicit(&st->nsrv, memory_order_acquire);
+	p->nsrv = min(p->nsrv, BOARD_SRV_MAX);
+
+	for (i = 0; i < p->nsrv; i++) {
+		struct board_srv *dst = &p->srv[i];
+		const struct shm_srv *src = &st->srv[i];
+
+		memcpy(dst->name, src->name, sizeof(dst->name));
+		dst->name[BOARD_SRV_NAME - 1] = 0;
+
+		dst->events = atomic_load_explicit(&src->events, memory_order_relaxed);
+		dst->failures = atomic_load_explicit(&src->failures, memory_order_relaxed);
+		dst->dropped = atomic_load_explicit(&src->dropped, memory_order_relaxed);
+		dst->coalesced = atomic_load_explicit(&src->coalesced, memory_order_relaxed);
+		dst->skipped = atomic_load_explicit(&src->skipped, memory_order_relaxed);
+		dst->restarts = atomic_load_explicit(&src->restarts, memory_order_relaxed);
+		dst->health = atomic_load_explicit(&src->health, memory_order_relaxed);
+		dst->last_success = atomic_load_explicit(&src->last_success, memory_order_relaxed);
+
+		shm_hist_load(&dst->wait, &src->wait);
+		shm_hist_load(&dst->latency, &src->latency);
+		shm_hist_load(&dst->age, &src->age);
+	}
+
+	for (i = 0; i < BOARD_HIST_MAX; i++) {
+		shm_hist_load(&p->hist[i], &st->hist[i]);
+	}
+
+	p->backfill.state = atomic_load_explicit(&st->backfill.state, memory_order_relaxed);
+	p->backfill.from = atomic_load_explicit(&st->backfill.from, memory_order_relaxed);
+	p->backfill.current = atomic_load_explicit(&st->backfill.current, memory_order_relaxed);
+	p->backfill.records = atomic_load_explicit(&st->backfill.records, memory_order_relaxed);
+
+	p->writer.saved = atomic_load_explicit(&st->writer.saved, memory_order_relaxed);
+	p->writer.lost = atomic_load_explicit(&st->writer.lost, memory_order_relaxed);
+
+	p->log.logged = atomic_load_explicit(&st->log.logged, memory_order_relaxed);
+	p->log.repeated = atomic_load_explicit(&st->log.repeated, memory_order_relaxed);
+	p->log.dropped = atomic_load_explicit(&st->log.dropped, memory_order_relaxed);
+
+	p->memory.rss = atomic_load_explicit(&st->memory.rss, memory_order_relaxed);
+	p->memory.peak = atomic_load_explicit(&st->memory.peak, memory_order_relaxed);
+
+	return 0;
+}
+
+/**
+ * Estimates the quantile {@code q} (from 0 to 1) of the histogram pointed to
+ * by {@code p}, in microseconds.
+ *
+ * The estimate is the upper bound of the bucket holding the quantile, hence
+ * at most twice the actual value, and never above the highest sample.
+ */
+unsigned long
+board_hist_quantile(const struct board_hist *p, double q)
+{
+	int i;
+	unsigned long n, rank;
+
+	if (p->count == 0) {
+		return 0;
+	}
+
+	rank = q * p->count;
+	if (rank < q * p->count || rank < 1) {
+		rank++;
+	}
+
+	n = 0;
+	for (i = 0; i < BOARD_HIST_BUCKETS - 1; i++) {
+		n += p->bucket[i];
+
+		if (rank <= n) {
+			break;
+		}
+	}
+
+	return min(1UL << (i + 1), p->max);
+}
+
+/**
+ * Returns the board update counter.
+ *
+ * The counter is incremented each time a loop or archive element is pushed
+ * to the board.
+ */
+unsigned int
+board_seq(void)
+{
+	return atomic_load_explicit(&boardp->update, memory_order_acquire);
+}
+
+/**
+ * Waits for a board update.
+ *
+ * The function blocks until the board update counter differs from the value
+ * pointed to by {@code seq}, which is then updated with the new value. The
+ * {@code timeout} argument specifies the number of milliseconds to wait, or
+ * a negative value to wait forever.
+ *
+ * On timeout, -1 is returned, and errno is set to ETIMEDOUT.
+ */
+int
+board_wait(unsigned int *seq, int timeout)
+{
+	struct timespec now, end;
+
+	if (timeout >= 0) {
+		(void) clock_gettime(CLOCK_MONOTONIC, &end);
+
+		end.tv_sec += timeout / 1000;
+		end.tv_nsec += (timeout % 1000) * 1000000;
+
+		if (end.tv_nsec >= 1000000000) {
+			end.tv_sec++;
+			end.tv_nsec -= 1000000000;
+		}
+	}
+
+	while (board_seq() == *seq) {
+		struct timespec ts, *tsp;
+
+		if (timeout < 0) {
+			tsp = NULL;
+		} else {
+			(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+			ts.tv_sec = end.tv_sec - now.tv_sec;
+			ts.tv_nsec = end.tv_nsec - now.tv_nsec;
+
+			if (ts.tv_nsec < 0) {
+				ts.tv_sec--;
+				ts.tv_nsec += 1000000000;
+			}
+			if (ts.tv_sec < 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+
+			tsp = &ts;
+		}
+
+		if (futex(&boardp->update, FUTEX_WAIT, *seq, tsp) == -1) {
+			if (errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+				return -1;
+			}
+		}
+	}
+
+	*seq = board_seq();
+
+	return 0;
+}
+
+int
+board_get(size_t i, struct ws_loop *p)
+{
+	struct ws_loop_pack pbuf;
+
+	if (!(boardp->flags & BOARD_PACKED)) {
+		return shm_buf_get(&boardp->loop, i, p, sizeof(*p));
+	}
+
+	if (shm_buf_get(&boardp->loop, i, &pbuf, sizeof(pbuf)) == -1) {
+		return -1;
+	}
+
+	ws_loop_unpack(p, &pbuf);
+
+	return 0;
+}
+
+int
+board_get_ar(size_t i, struct ws_archive *p)
+{
+	struct ws_archive_pack pbuf;
+
+	if (!(boardp->flags & BOARD_PACKED)) {
+		return shm_buf_get(&boardp->ar, i, p, sizeof(*p));
+	}
+
+	if (shm_buf_get(&boardp->ar, i, &pbuf, sizeof(pbuf)) == -1) {
+		return -1;
+	}
+
+	ws_archive_unpack(p, &pbuf);
+
+	return 0;
 }
@@ -1,27 +1,185 @@
 #ifndef _BOARD_H
 #define _BOARD_H
 
+#include "libws/aggregate.h"
+
 #include "dataset.h"
+#include "window.h"
 
 /*
  * Shared board.
  */
 
+#define BOARD_PACKED 0x1		/* Packed records */
+#define BOARD_COLUMNS 0x2		/* Loop columns */
+
+#define BOARD_SRV_MAX 8			/* Max number of services */
+#define BOARD_SRV_NAME 16		/* Service name size */
+#define BOARD_HIST_BUCKETS 24		/* Latency histogram buckets */
+
+/**
+ * Measures: pipeline stages, in processing order, then sensor timer jitter.
+ */
+enum board_hist_id
+{
+	BOARD_HIST_DRV_RT,		/* Driver sensor read */
+	BOARD_HIST_PUSH_RT,		/* Board sensor update */
+	BOARD_HIST_DRV_AR,		/* Driver archive read */
+	BOARD_HIST_PUSH_AR,		/* Board archive update */
+	BOARD_HIST_SQLITE,		/* SQLite insert */
+	BOARD_HIST_DISPATCH,		/* Notification of services */
+	BOARD_HIST_JITTER,		/* Sensor timer jitter */
+	BOARD_HIST_CHECKPOINT,		/* SQLite checkpoint */
+	BOARD_HIST_MAX			/* do not use */
+};
+
+/**
+ * Service health, as seen by the worker supervisor.
+ */
+enum board_health
+{
+	BOARD_HEALTH_OK,		/* Running */
+	BOARD_HEALTH_DEGRADED,		/* Failing, retried with backoff */
+	BOARD_HEALTH_OPEN,		/* Suspended after repeated failures */
+	BOARD_HEALTH_DEAD,		/* Stopped unexpectedly, to be restarted */
+	BOARD_HEALTH_DISABLED		/* Could not be initialized */
+};
+
+enum board_backfill_state
+{
+	BOARD_BACKFILL_NONE,		/* No missed archive */
+	BOARD_BACKFILL_RUNNING,		/* Fetching missed archives */
+	BOARD_BACKFILL_DONE,		/* All missed archives fetched */
+	BOARD_BACKFILL_FAILED		/* Failed, to be retried */
+};
+
+/**
+ * Latency histogram, in microseconds.
+ *
+ * Bucket {@code i} counts samples from 2^i to 2^(i+1) µs (excluded), the
+ * first one also counts samples below 1 µs, and the last one all samples
+ * above.
+ */
+struct board_hist
+{
+	unsigned long count;		/* Number of samples */
+	unsigned long long sum;		/* Sum of samples */
+	unsigned long max;		/* Highest sample */
+	unsigned long bucket[BOARD_HIST_BUCKETS];
+};
+
+struct board_srv
+{
+	char name[BOARD_SRV_NAME];	/* Service name */
+	unsigned long events;		/* Handled events */
+	unsigned long failures;		/* Failed events */
+	unsigned long dropped;		/* Dropped notifications */
+	unsigned long coalesced;	/* Coalesced notifications */
+	unsigned long skipped;		/* Events skipped during backoff */
+	unsigned long restarts;		/* Restarts by the supervisor */
+	enum board_health health;	/* Health */
+	time_t last_success;		/* Last successful event */
+	struct board_hist wait;		/* Time spent in queue */
+	struct board_hist latency;	/* Event handling latency */
+	struct board_hist age;		/* Sample age when handled */
+};
+
+/**
+ * Progress of the archive backfill.
+ */
+struct board_backfill
+{
+	enum board_backfill_state state; /* State */
+	time_t from;			/* Last record before backfill */
+	time_t current;			/* Last fetched record */
+	unsigned long records;		/* Fetched records */
+};
+
+/**
+ * Database writer counters.
+ */
+struct board_writer
+{
+	unsigned long saved;		/* Records saved */
+	unsigned long lost;		/* Records not saved */
+};
+
+/**
+ * Logging counters.
+ */
+struct board_log
+{
+	unsigned long logged;		/* Messages written to syslog */
+	unsigned long repeated;		/* Repeated messages folded */
+	unsigned long dropped;		/* Messages dropped */
+};
+
+/**
+ * Daemon memory, in kB.
+ */
+struct board_memory
+{
+	long rss;			/* Resident size */
+	long peak;			/* Peak resident size */
+};
+
+struct board_stats
+{
+	size_t nsrv;			/* Number of services */
+	struct board_srv srv[BOARD_SRV_MAX];
+	struct board_hist hist[BOARD_HIST_MAX];
+	struct board_backfill backfill;	/* Archive backfill */
+	struct board_writer writer;	/* Database writer */
+	struct board_log log;		/* Logging */
+	struct board_memory memory;	/* Daemon memory */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-ssize_t board_open(int oflag, ...);
+ssize_t board_open(const char *station, const char *path, int oflag, ...);
 int board_unlink(void);
-
-int board_lock(void);
-int board_unlock(void);
+int board_restored(void);
 
 void board_push(const struct ws_loop *p);
 void board_push_ar(const struct ws_archive *p);
 
-struct ws_loop *board_peek(size_t i);
-struct ws_archive *board_peek_ar(size_t i);
+int board_get(size_t i, struct ws_loop *p);
+int board_get_ar(size_t i, struct ws_archive *p);
+
+ssize_t board_copy_loops(struct ws_loop *dst, time_t from, size_t max);
+ssize_t board_copy_ar(struct ws_archive *dst, time_t from, size_t max);
+void board_size(size_t *nloops, size_t *nar);
+size_t board_loop_size(int flags);
+
+int board_aggr(int field, enum aggr_type type, time_t from, time_t to, double *v);
+int board_window(long len, int field, struct win_stat *p);
+int board_window_wind(long len, double *speed, double *dir);
+void board_window_expire(time_t t);
+
+void board_stat_register(size_t srv, const char *name);
+void board_stat_event(size_t srv, int ret, const struct timespec *start);
+void board_stat_wait(size_t srv, const struct timespec *queued);
+void board_stat_age(size_t srv, const struct timespec *origin);
+void board_stat_drop(size_t srv);
+void board_stat_coalesce(size_t srv);
+void board_stat_skip(size_t srv);
+void board_stat_restart(size_t srv);
+void board_stat_health(size_t srv, enum board_health health);
+void board_stat_time(enum board_hist_id id, const struct timespec *start);
+void board_stat_sample(enum board_hist_id id, unsigned long us);
+void board_stat_backfill(enum board_backfill_state state, time_t from,
+		time_t current, unsigned long records);
+void board_stat_writer(unsigned long saved, unsigned long lost);
+void board_stat_log(unsigned long logged, unsigned long repeated,
+		unsigned long dropped);
+void board_stat_memory(long rss, long peak);
+int board_stats(struct board_stats *p);
+unsigned long board_hist_quantile(const struct board_hist *p, double q);
+
+unsigned int board_seq(void);
+int board_wait(unsigned int *seq, int timeout);
 
 #ifdef __cplusplus
 }
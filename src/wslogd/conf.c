@@ -6,6 +6,7 @@
 #include "config.h"
 #endif
 
+#include <sched.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -17,6 +18,7 @@
 #include "libws/conf.h"
 
 #include "conf.h"
+#include "log.h"
 
 struct code
 {
@@ -24,6 +26,10 @@ struct code
 	int c_val;
 };
 
+/* Default strings, not allocated */
+static const char default_tty[] = "/dev/ttyUSB0";
+static const char default_db[] = WS_CONF_SQLITE_DB;
+
 static struct code log_levels[] =
 {
 	{ "alert", LOG_ALERT },
@@ -60,6 +66,21 @@ static struct code log_facilities[] =
 	{ "local7", LOG_LOCAL7 }
 };
 
+static const char *journal_modes[] =
+{
+	"delete", "truncate", "persist", "memory", "wal", "off"
+};
+
+static const char *synchronous_modes[] =
+{
+	"off", "normal", "full", "extra"
+};
+
+static const char *temp_stores[] =
+{
+	"default", "file", "memory"
+};
+
 static struct ws_conf conf;
 
 struct ws_conf *confp = &conf;
@@ -84,6 +105,26 @@ code_search(const struct code *c, size_t nel, const char *name, int *code)
 	return ret;
 }
 
+/**
+ * Looks {@code str} up in the {@code nel} words of {@code words}, and
+ * stores the matching word into {@code word}.
+ */
+static int
+word_search(const char **words, size_t nel, const char *str, const char **word)
+{
+	size_t i;
+
+	for (i = 0; i < nel; i++) {
+		if (!strcmp(str, words[i])) {
+			*word = words[i];
+			return 0;
+		}
+	}
+
+	errno = EINVAL;
+	return -1;
+}
+
 int
 ws_getdriver(const char *str, enum ws_driver *driver)
 {
@@ -116,6 +157,36 @@ ws_getdriver(const char *str, enum ws_driver *driver)
 	return ret;
 }
 
+int
+ws_getengine(const char *str, enum ws_engine *engine)
+{
+	if (!strcmp(str, "threads")) {
+		*engine = ENGINE_THREADS;
+	} else if (!strcmp(str, "reactor")) {
+		*engine = ENGINE_REACTOR;
+	} else {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+int
+ws_getprofile(const char *str, enum ws_profile *profile)
+{
+	if (!strcmp(str, "default")) {
+		*profile = PROFILE_DEFAULT;
+	} else if (!strcmp(str, "small")) {
+		*profile = PROFILE_SMALL;
+	} else {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
 int
 ws_getlevel(const char *str, int *level)
 {
@@ -132,6 +203,180 @@ ws_getfacility(const char *str, int *facility)
 	return code_search(log_facilities, nel, str, facility);
 }
 
+/**
+ * Decodes an event delivery policy: "queue", "drop-oldest" or "latest".
+ */
+static int
+ws_getdelivery(const char *str, enum queue_policy *policy)
+{
+	if (!strcmp(str, "queue")) {
+		*policy = QUEUE_ALL;
+	} else if (!strcmp(str, "drop-oldest")) {
+		*policy = QUEUE_DROP_OLDEST;
+	} else if (!strcmp(str, "latest")) {
+		*policy = QUEUE_LATEST;
+	} else {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+ws_getpolicy(const char *str, int *policy)
+{
+	if (!strcmp(str, "other")) {
+		*policy = SCHED_OTHER;
+	} else if (!strcmp(str, "fifo")) {
+		*policy = SCHED_FIFO;
+	} else if (!strcmp(str, "rr")) {
+		*policy = SCHED_RR;
+	} else {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Parses a list of CPUs (for example "0,2-3") into a mask.
+ */
+static int
+ws_getcpus(const char *str, unsigned long *cpus)
+{
+	const char *p = str;
+
+	*cpus = 0;
+
+	do {
+		char *end;
+		unsigned long lo, hi;
+
+		errno = 0;
+		lo = hi = strtoul(p, &end, 10);
+		if (*end == '-') {
+			hi = strtoul(end + 1, &end, 10);
+		}
+
+		if (errno || end == p || hi < lo || 8 * sizeof(*cpus) <= hi
+				|| (*end != ',' && *end != 0)) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		for (; lo <= hi; lo++) {
+			*cpus |= 1UL << lo;
+		}
+
+		p = end + 1;
+	} while (p[-1] == ',');
+
+	return 0;
+}
+
+/**
+ * Tells whether {@code key} is a thread option, once stripped of its service
+ * prefix.
+ */
+static int
+sched_key(const char *key)
+{
+	return !strcmp(key, "sched") || !strcmp(key, "priority")
+			|| !strcmp(key, "cpus") || !strcmp(key, "stack");
+}
+
+static int
+ws_getsched(const char *key, const char *value, struct ws_sched *p)
+{
+	if (!strcmp(key, "sched")) {
+		return ws_getpolicy(value, &p->policy);
+	} else if (!strcmp(key, "priority")) {
+		return ws_getint(value, &p->priority);
+	} else if (!strcmp(key, "cpus")) {
+		return ws_getcpus(value, &p->cpus);
+	} else {
+		long kb;
+
+		/* Stack size, in kB */
+		if (ws_getlong(value, &kb) == -1) {
+			return -1;
+		}
+		if (kb < 0) {
+			errno = EINVAL;
+			return -1;
+		}
+
+		p->stack = kb * 1024;
+	}
+
+	return 0;
+}
+
+/**
+ * Parses a list of rolling windows, separated by spaces. Each window is a
+ * duration (see ws_getduration()), or "day" for the calendar day.
+ */
+static int
+ws_getwindows(const char *str, long *windows, size_t *nwindows)
+{
+	size_t n;
+	char *buf, *tok, *saveptr;
+
+	if ((buf = strdup(str)) == NULL) {
+		return -1;
+	}
+
+	n = 0;
+	tok = strtok_r(buf, " ", &saveptr);
+
+	while (tok != NULL) {
+		long len;
+
+		if (n == WIN_MAX) {
+			errno = EINVAL;
+			goto error;
+		}
+
+		if (!strcmp(tok, "day")) {
+			len = WIN_DAY;
+		} else if (ws_getduration(tok, &len) == -1) {
+			goto error;
+		} else if (len == 0) {
+			errno = EINVAL;
+			goto error;
+		}
+
+		windows[n++] = len;
+		tok = strtok_r(NULL, " ", &saveptr);
+	}
+
+	*nwindows = n;
+	free(buf);
+
+	return 0;
+
+error:
+	free(buf);
+	return -1;
+}
+
+static void
+str_free(const char *s)
+{
+	if (s != default_tty && s != default_db) {
+		free((char *) s);
+	}
+}
+
+static void
+str_set(const char **p, const char *value)
+{
+	str_free(*p);
+	*p = strdup(value);
+}
+
 static int
 conf_init(struct ws_conf *cfg)
 {
@@ -141,21 +386,44 @@ conf_init(struct ws_conf *cfg)
 	cfg->log_facility = LOG_USER;
 	cfg->log_level = LOG_NOTICE;
 
+	cfg->station.name = NULL;
 	cfg->station.driver = UNUSED;
 
 	/* Default driver */
 	cfg->driver.freq = 0;
 #if HAVE_VANTAGE
-	cfg->driver.vantage.tty = "/dev/ttyUSB0";
+	cfg->driver.vantage.tty = default_tty;
 #endif
 #if HAVE_WS23XX
-	cfg->driver.ws23xx.tty = "/dev/ttyUSB0";
+	cfg->driver.ws23xx.tty = default_tty;
 #endif
 #if HAVE_VIRT
 	cfg->driver.virt.hw_archive = 1;
 	cfg->driver.virt.io_delay = 100;
 #endif
 
+	/* Service engine */
+	cfg->worker.engine = ENGINE_THREADS;
+	cfg->worker.modules = NULL;
+#if ENABLE_SMALL
+	cfg->worker.profile = PROFILE_SMALL;
+#else
+	cfg->worker.profile = PROFILE_DEFAULT;
+#endif
+
+	/* Shared board */
+	cfg->board.file = NULL;
+	cfg->board.loop_history = 0;
+	cfg->board.ar_history = 0;
+	cfg->board.packed = 0;
+	cfg->board.columns = 0;
+	cfg->board.windows[0] = 60;
+	cfg->board.windows[1] = 600;
+	cfg->board.windows[2] = 3600;
+	cfg->board.windows[3] = 86400;
+	cfg->board.windows[4] = WIN_DAY;
+	cfg->board.nwindows = 5;
+
 	/* Time synchronization */
 	cfg->sync.enabled = 1;
 	cfg->sync.freq = 7200;
@@ -167,11 +435,20 @@ conf_init(struct ws_conf *cfg)
 
 	/* SQLite */
 	cfg->archive.sqlite.enabled = 1;
-	cfg->archive.sqlite.db = WS_CONF_SQLITE_DB;
+	cfg->archive.sqlite.db = default_db;
+	cfg->archive.sqlite.commit_delay = 0;
+	cfg->archive.sqlite.journal_mode = NULL;
+	cfg->archive.sqlite.synchronous = NULL;
+	cfg->archive.sqlite.temp_store = NULL;
+	cfg->archive.sqlite.cache_size = 0;
+	cfg->archive.sqlite.mmap_size = 0;
+	cfg->archive.sqlite.checkpoint = 1000;
 
 	/* StatIC */
 	cfg->stat_ic.enabled = 0;
 	cfg->stat_ic.freq = 600;
+	cfg->stat_ic.delivery = QUEUE_ALL;
+	cfg->stat_ic.queue = 32;
 
 	/* Wunderstation */
 	cfg->wunder.enabled = 0;
@@ -193,7 +470,9 @@ conf_decode(void *p, const char *key, const char *value)
 	} else if (!strcmp(key, "log_level")) {
 		ws_getlevel(value, &cfg->log_level);
 	} else if (!strncmp(key, "station.", 8)) {
-		if (!strcmp(key, "station.latitude")) {
+		if (!strcmp(key, "station.name")) {
+			str_set(&cfg->station.name, value);
+		} else if (!strcmp(key, "station.latitude")) {
 			ws_getfloat(value, &cfg->station.latitude);
 		} else if (!strcmp(key, "station.longitude")) {
 			ws_getfloat(value, &cfg->station.longitude);
@@ -207,13 +486,15 @@ conf_decode(void *p, const char *key, const char *value)
 	} else if (!strncmp(key, "driver.", 7)) {
 		if (!strcmp(key, "driver.freq")) {
 			ws_getlong(value, &cfg->driver.freq);
+		} else if (sched_key(key + 7)) {
+			ws_getsched(key + 7, value, &cfg->driver.sched);
 #if HAVE_VANTAGE
 		} else if (!strcmp(key, "driver.vantage.tty")) {
-			cfg->driver.vantage.tty = strdup(value);
+			str_set(&cfg->driver.vantage.tty, value);
 #endif
 #if HAVE_WS23XX
 		} else if (!strcmp(key, "driver.ws23xx.tty")) {
-			cfg->driver.ws23xx.tty = strdup(value);
+			str_set(&cfg->driver.ws23xx.tty, value);
 #endif
 #if HAVE_VIRT
 		} else if (!strcmp(key, "driver.virt.hw_archive")) {
@@ -224,6 +505,34 @@ conf_decode(void *p, const char *key, const char *value)
 		} else {
 			errno = EINVAL;
 		}
+	} else if (!strncmp(key, "worker.", 7)) {
+		if (!strcmp(key, "worker.engine")) {
+			ws_getengine(value, &cfg->worker.engine);
+		} else if (!strcmp(key, "worker.modules")) {
+			str_set(&cfg->worker.modules, value);
+		} else if (!strcmp(key, "worker.mlock")) {
+			ws_getbool(value, &cfg->worker.mlock);
+		} else if (!strcmp(key, "worker.profile")) {
+			ws_getprofile(value, &cfg->worker.profile);
+		} else {
+			errno = EINVAL;
+		}
+	} else if (!strncmp(key, "board.", 6)) {
+		if (!strcmp(key, "board.file")) {
+			str_set(&cfg->board.file, value);
+		} else if (!strcmp(key, "board.loop_history")) {
+			ws_getduration(value, &cfg->board.loop_history);
+		} else if (!strcmp(key, "board.ar_history")) {
+			ws_getduration(value, &cfg->board.ar_history);
+		} else if (!strcmp(key, "board.packed")) {
+			ws_getbool(value, &cfg->board.packed);
+		} else if (!strcmp(key, "board.columns")) {
+			ws_getbool(value, &cfg->board.columns);
+		} else if (!strcmp(key, "board.windows")) {
+			ws_getwindows(value, cfg->board.windows, &cfg->board.nwindows);
+		} else {
+			errno = EINVAL;
+		}
 	} else if (!strncmp(key, "sync.", 4)) {
 		if (!strcmp(key, "sync.enabled")) {
 			ws_getint(value, &cfg->sync.enabled);
@@ -231,6 +540,8 @@ conf_decode(void *p, const char *key, const char *value)
 			ws_getint(value, &cfg->sync.freq);
 		} else if (!strcmp(key, "sync.max_drift")) {
 			ws_getint(value, &cfg->sync.max_drift);
+		} else if (sched_key(key + 5)) {
+			ws_getsched(key + 5, value, &cfg->sync.sched);
 		} else {
 			errno = EINVAL;
 		}
@@ -242,7 +553,26 @@ conf_decode(void *p, const char *key, const char *value)
 		} else if (!strcmp(key, "archive.sqlite.enabled")) {
 			ws_getbool(value, &cfg->archive.sqlite.enabled);
 		} else if (!strcmp(key, "archive.sqlite.db")) {
-			cfg->archive.sqlite.db = strdup(value);
+			str_set(&cfg->archive.sqlite.db, value);
+		} else if (!strcmp(key, "archive.sqlite.commit_delay")) {
+			ws_getduration(value, &cfg->archive.sqlite.commit_delay);
+		} else if (!strcmp(key, "archive.sqlite.journal_mode")) {
+			word_search(journal_modes, array_size(journal_modes), value,
+					&cfg->archive.sqlite.journal_mode);
+		} else if (!strcmp(key, "archive.sqlite.synchronous")) {
+			word_search(synchronous_modes, array_size(synchronous_modes), value,
+					&cfg->archive.sqlite.synchronous);
+		} else if (!strcmp(key, "archive.sqlite.temp_store")) {
+			word_search(temp_stores, array_size(temp_stores), value,
+					&cfg->archive.sqlite.temp_store);
+		} else if (!strcmp(key, "archive.sqlite.cache_size")) {
+			ws_getlong(value, &cfg->archive.sqlite.cache_size);
+		} else if (!strcmp(key, "archive.sqlite.mmap_size")) {
+			ws_getlong(value, &cfg->archive.sqlite.mmap_size);
+		} else if (!strcmp(key, "archive.sqlite.checkpoint")) {
+			ws_getlong(value, &cfg->archive.sqlite.checkpoint);
+		} else if (sched_key(key + 8)) {
+			ws_getsched(key + 8, value, &cfg->archive.sched);
 		} else {
 			errno = EINVAL;
 		}
@@ -250,13 +580,19 @@ conf_decode(void *p, const char *key, const char *value)
 		if (!strcmp(key, "static.enabled")) {
 			ws_getbool(value, &cfg->stat_ic.enabled);
 		} else if (!strcmp(key, "static.station")) {
-			cfg->stat_ic.station = strdup(value);
+			str_set(&cfg->stat_ic.station, value);
 		} else if (!strcmp(key, "static.username")) {
-			cfg->stat_ic.username = strdup(value);
+			str_set(&cfg->stat_ic.username, value);
 		} else if (!strcmp(key, "static.password")) {
-			cfg->stat_ic.password = strdup(value);
+			str_set(&cfg->stat_ic.password, value);
 		} else if (!strcmp(key, "static.freq")) {
 			ws_getint(value, &cfg->stat_ic.freq);
+		} else if (!strcmp(key, "static.delivery")) {
+			ws_getdelivery(value, &cfg->stat_ic.delivery);
+		} else if (!strcmp(key, "static.queue")) {
+			ws_getint(value, &cfg->stat_ic.queue);
+		} else if (sched_key(key + 7)) {
+			ws_getsched(key + 7, value, &cfg->stat_ic.sched);
 		} else {
 			errno = EINVAL;
 		}
@@ -266,11 +602,13 @@ conf_decode(void *p, const char *key, const char *value)
 		} else if (!strcmp(key, "wunder.https")) {
 			ws_getbool(value, &cfg->wunder.https);
 		} else if (!strcmp(key, "wunder.station")) {
-			cfg->wunder.station = strdup(value);
+			str_set(&cfg->wunder.station, value);
 		} else if (!strcmp(key, "wunder.password")) {
-			cfg->wunder.password = strdup(value);
+			str_set(&cfg->wunder.password, value);
 		} else if (!strcmp(key, "wunder.freq")) {
 			ws_getint(value, &cfg->wunder.freq);
+		} else if (sched_key(key + 7)) {
+			ws_getsched(key + 7, value, &cfg->wunder.sched);
 		} else {
 			errno = EINVAL;
 		}
@@ -281,19 +619,59 @@ conf_decode(void *p, const char *key, const char *value)
 	return (errno == 0) ? 0 : -1;
 }
 
+static void
+sched_small(struct ws_sched *p)
+{
+	if (p->stack == 0) {
+		p->stack = WS_CONF_SMALL_STACK;
+	}
+}
+
+/**
+ * Applies the memory profile defaults to the options left unset.
+ */
+static void
+conf_profile(struct ws_conf *cfg)
+{
+	if (cfg->worker.profile == PROFILE_SMALL) {
+		sched_small(&cfg->driver.sched);
+		sched_small(&cfg->archive.sched);
+		sched_small(&cfg->sync.sched);
+		sched_small(&cfg->stat_ic.sched);
+		sched_small(&cfg->wunder.sched);
+	}
+}
+
+/**
+ * Reads the configuration file {@code path} into {@code cfg}, without
+ * changing the current configuration.
+ */
 int
-conf_load(const char *path)
+conf_read(const char *path, struct ws_conf *cfg)
 {
 	int lineno;
 
-	conf_init(&conf);
+	conf_init(cfg);
 
-	if (ws_parse_config(path, &lineno, conf_decode, &conf) == -1) {
+	if (ws_parse_config(path, &lineno, conf_decode, cfg) == -1) {
 		if (errno == EINVAL) {
-			syslog(LOG_ERR, "conf_load %s:%d: %m", path, lineno);
+			log_msg(LOG_ERR, "conf_load %s:%d: %m", path, lineno);
 		} else {
-			syslog(LOG_ERR, "conf_load %s: %m", path);
+			log_msg(LOG_ERR, "conf_load %s: %m", path);
 		}
+		conf_dispose(cfg);
+		return -1;
+	}
+
+	conf_profile(cfg);
+
+	return 0;
+}
+
+int
+conf_load(const char *path)
+{
+	if (conf_read(path, &conf) == -1) {
 		return -1;
 	}
 
@@ -302,8 +680,250 @@ conf_load(const char *path)
 	return 0;
 }
 
+/**
+ * Reloads the configuration file {@code path}, while services are stopped.
+ * The board section is kept.
+ */
+int
+conf_reload(const char *path)
+{
+	struct ws_conf cfg;
+
+	if (conf_read(path, &cfg) == -1) {
+		return -1;
+	}
+
+	conf_apply(&cfg, CONF_CORE);
+	conf_apply(&cfg, CONF_SYNC);
+	conf_apply(&cfg, CONF_STAT_IC);
+	conf_apply(&cfg, CONF_WUNDER);
+
+	conf_dispose(&cfg);
+
+	return 0;
+}
+
+static int
+str_eq(const char *s1, const char *s2)
+{
+	if (s1 == NULL || s2 == NULL) {
+		return s1 == s2;
+	}
+
+	return !strcmp(s1, s2);
+}
+
+static int
+sched_eq(const struct ws_sched *p, const struct ws_sched *q)
+{
+	return p->policy == q->policy
+			&& p->priority == q->priority
+			&& p->cpus == q->cpus
+			&& p->stack == q->stack;
+}
+
+static int
+conf_core_eq(const struct ws_conf *p, const struct ws_conf *q)
+{
+	if (p->log_facility != q->log_facility) {
+		return 0;
+	}
+
+	/* Station and driver */
+	if (p->station.latitude != q->station.latitude
+			|| p->station.longitude != q->station.longitude
+			|| p->station.altitude != q->station.altitude
+			|| p->station.driver != q->station.driver
+			|| p->driver.freq != q->driver.freq
+			|| !sched_eq(&p->driver.sched, &q->driver.sched)) {
+		return 0;
+	}
+#if HAVE_VANTAGE
+	if (!str_eq(p->driver.vantage.tty, q->driver.vantage.tty)
+			|| p->driver.vantage.baud != q->driver.vantage.baud) {
+		return 0;
+	}
+#endif
+#if HAVE_WS23XX
+	if (!str_eq(p->driver.ws23xx.tty, q->driver.ws23xx.tty)) {
+		return 0;
+	}
+#endif
+#if HAVE_VIRT
+	if (p->driver.virt.hw_archive != q->driver.virt.hw_archive
+			|| p->driver.virt.io_delay != q->driver.virt.io_delay) {
+		return 0;
+	}
+#endif
+
+	/* Worker */
+	if (p->worker.engine != q->worker.engine
+			|| !str_eq(p->worker.modules, q->worker.modules)
+			|| p->worker.mlock != q->worker.mlock
+			|| p->worker.profile != q->worker.profile) {
+		return 0;
+	}
+
+	/* Archive */
+	if (p->archive.freq != q->archive.freq
+			|| p->archive.delay != q->archive.delay
+			|| !sched_eq(&p->archive.sched, &q->archive.sched)
+			|| p->archive.sqlite.enabled != q->archive.sqlite.enabled
+			|| !str_eq(p->archive.sqlite.db, q->archive.sqlite.db)
+			|| p->archive.sqlite.commit_delay != q->archive.sqlite.commit_delay
+			|| !str_eq(p->archive.sqlite.journal_mode, q->archive.sqlite.journal_mode)
+			|| !str_eq(p->archive.sqlite.synchronous, q->archive.sqlite.synchronous)
+			|| !str_eq(p->archive.sqlite.temp_store, q->archive.sqlite.temp_store)
+			|| p->archive.sqlite.cache_size != q->archive.sqlite.cache_size
+			|| p->archive.sqlite.mmap_size != q->archive.sqlite.mmap_size
+			|| p->archive.sqlite.checkpoint != q->archive.sqlite.checkpoint) {
+		return 0;
+	}
+
+	/* Enabled services */
+	return p->sync.enabled == q->sync.enabled
+			&& p->stat_ic.enabled == q->stat_ic.enabled
+			&& p->wunder.enabled == q->wunder.enabled;
+}
+
+static int
+conf_board_eq(const struct ws_conf *p, const struct ws_conf *q)
+{
+	/* Board name */
+	if (!str_eq(p->station.name, q->station.name)) {
+		return 0;
+	}
+
+	return str_eq(p->board.file, q->board.file)
+			&& p->board.loop_history == q->board.loop_history
+			&& p->board.ar_history == q->board.ar_history
+			&& p->board.packed == q->board.packed
+			&& p->board.columns == q->board.columns
+			&& p->board.nwindows == q->board.nwindows
+			&& !memcmp(p->board.windows, q->board.windows,
+					p->board.nwindows * sizeof(*p->board.windows));
+}
+
+/**
+ * Tells whether the section {@code section} of {@code cfg} differs from the
+ * current configuration.
+ */
+int
+conf_changed(const struct ws_conf *cfg, enum conf_section section)
+{
+	const struct ws_conf *p = &conf;
+
+	switch (section) {
+	case CONF_CORE:
+		return !conf_core_eq(cfg, p);
+	case CONF_BOARD:
+		return !conf_board_eq(cfg, p);
+	case CONF_SYNC:
+		return cfg->sync.freq != p->sync.freq
+				|| cfg->sync.max_drift != p->sync.max_drift
+				|| !sched_eq(&cfg->sync.sched, &p->sync.sched);
+	case CONF_STAT_IC:
+		return !str_eq(cfg->stat_ic.station, p->stat_ic.station)
+				|| !str_eq(cfg->stat_ic.username, p->stat_ic.username)
+				|| !str_eq(cfg->stat_ic.password, p->stat_ic.password)
+				|| cfg->stat_ic.freq != p->stat_ic.freq
+				|| cfg->stat_ic.delivery != p->stat_ic.delivery
+				|| cfg->stat_ic.queue != p->stat_ic.queue
+				|| !sched_eq(&cfg->stat_ic.sched, &p->stat_ic.sched);
+	case CONF_WUNDER:
+		return cfg->wunder.https != p->wunder.https
+				|| !str_eq(cfg->wunder.station, p->wunder.station)
+				|| !str_eq(cfg->wunder.password, p->wunder.password)
+				|| cfg->wunder.freq != p->wunder.freq
+				|| !sched_eq(&cfg->wunder.sched, &p->wunder.sched);
+	default:
+		return 1;
+	}
+}
+
+static void
+mem_swap(void *a, void *b, size_t sz)
+{
+	unsigned char *p = a;
+	unsigned char *q = b;
+
+	for (; sz > 0; sz--, p++, q++) {
+		unsigned char c = *p;
+
+		*p = *q;
+		*q = c;
+	}
+}
+
+/**
+ * Moves the section {@code section} of {@code cfg} into the current
+ * configuration. The replaced options are moved into {@code cfg}, to be
+ * released with conf_dispose(). The board section is never moved, see
+ * conf_changed().
+ *
+ * Options of a service shall not be changed while the service is running.
+ * Core options other than the log level shall not be changed while services
+ * are running.
+ */
+void
+conf_apply(struct ws_conf *cfg, enum conf_section section)
+{
+	switch (section) {
+	case CONF_CORE:
+		conf.log_facility = cfg->log_facility;
+		conf.log_level = cfg->log_level;
+		conf.station.latitude = cfg->station.latitude;
+		conf.station.longitude = cfg->station.longitude;
+		conf.station.altitude = cfg->station.altitude;
+		conf.station.driver = cfg->station.driver;
+		mem_swap(&conf.worker, &cfg->worker, sizeof(conf.worker));
+		mem_swap(&conf.driver, &cfg->driver, sizeof(conf.driver));
+		mem_swap(&conf.archive, &cfg->archive, sizeof(conf.archive));
+		conf.sync.enabled = cfg->sync.enabled;
+		conf.stat_ic.enabled = cfg->stat_ic.enabled;
+		conf.wunder.enabled = cfg->wunder.enabled;
+		break;
+	case CONF_BOARD:
+		break;
+	case CONF_SYNC:
+		mem_swap(&conf.sync, &cfg->sync, sizeof(conf.sync));
+		break;
+	case CONF_STAT_IC:
+		mem_swap(&conf.stat_ic, &cfg->stat_ic, sizeof(conf.stat_ic));
+		break;
+	case CONF_WUNDER:
+		mem_swap(&conf.wunder, &cfg->wunder, sizeof(conf.wunder));
+		break;
+	}
+}
+
+/**
+ * Releases the strings of {@code cfg}.
+ */
+void
+conf_dispose(struct ws_conf *cfg)
+{
+	str_free(cfg->station.name);
+	str_free(cfg->worker.modules);
+#if HAVE_VANTAGE
+	str_free(cfg->driver.vantage.tty);
+#endif
+#if HAVE_WS23XX
+	str_free(cfg->driver.ws23xx.tty);
+#endif
+	str_free(cfg->board.file);
+	str_free(cfg->archive.sqlite.db);
+	str_free(cfg->stat_ic.station);
+	str_free(cfg->stat_ic.username);
+	str_free(cfg->stat_ic.password);
+	str_free(cfg->wunder.station);
+	str_free(cfg->wunder.password);
+
+	memset(cfg, 0, sizeof(*cfg));
+}
+
 void
 conf_free(void)
 {
-	memset(&conf, 0, sizeof(conf));
+	conf_dispose(&conf);
 }
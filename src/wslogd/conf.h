@@ -4,12 +4,55 @@
 #include <termios.h>
 
 #include "driver/driver.h"
+#include "queue.h"
+#include "window.h"
 
 /*
  * Weather station configuration.
  */
 
 #define WS_CONF_SQLITE_DB "/var/lib/wslog/wslogd.db"
+#define WS_CONF_SMALL_STACK 131072		/* Small profile thread stack */
+
+/**
+ * Configuration sections, as far as reload is concerned.
+ *
+ * The core section holds all options, but the board ones and the options of
+ * each service. The set of enabled services is part of the core section. The
+ * board section, the station name and the board options, is fixed for the
+ * process lifetime: the board is opened once, and clients stay attached to it.
+ */
+enum conf_section
+{
+	CONF_CORE,				/* Daemon, station, archive */
+	CONF_BOARD,				/* Shared board */
+	CONF_SYNC,				/* Time synchronization service */
+	CONF_STAT_IC,				/* StatIC service */
+	CONF_WUNDER				/* Weather Underground service */
+};
+
+enum ws_engine
+{
+	ENGINE_THREADS,				/* One thread per service */
+	ENGINE_REACTOR				/* Single-threaded event loop */
+};
+
+enum ws_profile
+{
+	PROFILE_DEFAULT,			/* Library and system defaults */
+	PROFILE_SMALL				/* Low-memory sizes */
+};
+
+/**
+ * Thread options of a service. Zero values keep the system defaults.
+ */
+struct ws_sched
+{
+	int policy;				/* SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+	int priority;				/* Static priority */
+	unsigned long cpus;			/* CPU affinity mask, 0 for any */
+	size_t stack;				/* Stack size, in bytes */
+};
 
 struct ws_conf
 {
@@ -18,15 +61,25 @@ struct ws_conf
 
 	struct
 	{
+		const char *name;		/* Station name */
 		float latitude;			/* Latitude */
 		float longitude;		/* Longitude */
 		int altitude;			/* Altitude (m) */
 		enum ws_driver driver;		/* Station type */
 	} station;
 
+	struct
+	{
+		enum ws_engine engine;		/* Service engine */
+		const char *modules;		/* Service shared objects */
+		int mlock;			/* Lock memory */
+		enum ws_profile profile;	/* Memory profile */
+	} worker;
+
 	struct
 	{
 		long freq;			/* Sensor frequency, in milliseconds */
+		struct ws_sched sched;		/* Sensor thread options */
 
 		struct
 		{
@@ -44,15 +97,34 @@ struct ws_conf
 		} virt;
 	} driver;
 
+	struct
+	{
+		const char *file;		/* Backing file */
+		long loop_history;		/* Loop history, in seconds */
+		long ar_history;		/* Archive history, in seconds */
+		int packed;			/* Packed records */
+		int columns;			/* Loop columns */
+		long windows[WIN_MAX];		/* Rolling windows length */
+		size_t nwindows;		/* Number of rolling windows */
+	} board;
+
 	struct
 	{
 		int freq;			/* Archive frequency, in seconds */
 		int delay;			/* Archive delay, in seconds */
+		struct ws_sched sched;		/* Archive thread options */
 
 		struct
 		{
 			int enabled;		/* Enabled flag */
 			const char *db;		/* Database file */
+			long commit_delay;	/* Group commit delay, in seconds */
+			const char *journal_mode; /* Journal mode, NULL for default */
+			const char *synchronous; /* Synchronous mode, NULL for default */
+			const char *temp_store;	/* Temporary storage, NULL for default */
+			long cache_size;	/* Page cache, in kB, 0 for default */
+			long mmap_size;		/* Memory map, in kB, 0 for default */
+			long checkpoint;	/* WAL pages triggering a checkpoint */
 		} sqlite;
 	} archive;
 
@@ -61,6 +133,7 @@ struct ws_conf
 		int enabled;			/* Enabled flag */
 		int freq;			/* Synchronization frequency, in seconds */
 		int max_drift;			/* Max drift, in seconds */
+		struct ws_sched sched;		/* Thread options */
 	} sync;
 
 	struct
@@ -70,6 +143,9 @@ struct ws_conf
 		const char *username;		/* Username id */
 		const char *password;		/* Account password */
 		int freq;			/* Update frequency, in seconds */
+		enum queue_policy delivery;	/* Event delivery policy */
+		int queue;			/* Event queue length */
+		struct ws_sched sched;		/* Thread options */
 	} stat_ic;
 
 	struct
@@ -79,6 +155,7 @@ struct ws_conf
 		const char *station;		/* Station id */
 		const char *password;		/* Account password */
 		int freq;			/* Update frequency, in seconds */
+		struct ws_sched sched;		/* Thread options */
 	} wunder;
 };
 
@@ -91,10 +168,17 @@ extern "C" {
 int ws_getuid(const char *str, uid_t *uid);
 int ws_getgid(const char *str, gid_t *gid);
 int ws_getdriver(const char *str, enum ws_driver *driver);
+int ws_getengine(const char *str, enum ws_engine *engine);
+int ws_getprofile(const char *str, enum ws_profile *profile);
 int ws_getlevel(const char *str, int *level);
 int ws_getfacility(const char *str, int *facility);
 
 int conf_load(const char *path);
+int conf_reload(const char *path);
+int conf_read(const char *path, struct ws_conf *cfg);
+int conf_changed(const struct ws_conf *cfg, enum conf_section section);
+void conf_apply(struct ws_conf *cfg, enum conf_section section);
+void conf_dispose(struct ws_conf *cfg);
 void conf_free(void);
 
 #ifdef __cplusplus
@@ -7,6 +7,13 @@
 #include <unistd.h>
 #include <curl/curl.h>
 
+#include "log.h"
+
+#define CURL_CONNECT_TIMEOUT 5L	/* Connection timeout, in seconds */
+#define CURL_TIMEOUT 15L		/* Transfer timeout, in seconds */
+#define CURL_SMALL_BUFFER 4096L		/* Small profile receive buffer */
+#define CURL_SMALL_UPLOAD 16384L	/* Small profile upload buffer */
+
 static
 ssize_t fdread(void *ptr, size_t size, size_t nmemb, intptr_t fd)
 {
@@ -16,7 +23,7 @@ ssize_t fdread(void *ptr, size_t size, size_t nmemb, intptr_t fd)
 void
 curl_log(const char *fn, CURLcode code)
 {
-	syslog(LOG_ERR, "%s: %s (%d)", fn, curl_easy_strerror(code), code);
+	log_msg(LOG_ERR, "%s: %s (%d)", fn, curl_easy_strerror(code), code);
 }
 
 CURLcode
@@ -69,3 +76,65 @@ curl_easy_upload(CURL *h, const char *url, int fd)
 error:
 	return code;
 }
+
+/**
+ * Shrinks the transfer buffers of {@code h}, for the small profile.
+ */
+CURLcode
+curl_easy_small(CURL *h)
+{
+	CURLcode code;
+
+	code = curl_easy_setopt(h, CURLOPT_BUFFERSIZE, CURL_SMALL_BUFFER);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+
+#if LIBCURL_VERSION_NUM >= 0x073e00
+	code = curl_easy_setopt(h, CURLOPT_UPLOAD_BUFFERSIZE, CURL_SMALL_UPLOAD);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+#endif
+
+	code = curl_easy_setopt(h, CURLOPT_MAXCONNECTS, 1L);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+
+	return CURLE_OK;
+
+error:
+	return code;
+}
+
+/**
+ * Bounds the connection and transfer time of {@code h}, so that a stalled
+ * upload does not hold its service (or the reactor) for long.
+ */
+CURLcode
+curl_easy_timeout(CURL *h)
+{
+	CURLcode code;
+
+	/* Timeouts shall not raise signals in threads */
+	code = curl_easy_setopt(h, CURLOPT_NOSIGNAL, 1L);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+
+	code = curl_easy_setopt(h, CURLOPT_CONNECTTIMEOUT, CURL_CONNECT_TIMEOUT);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+
+	code = curl_easy_setopt(h, CURLOPT_TIMEOUT, CURL_TIMEOUT);
+	if (code != CURLE_OK) {
+		goto error;
+	}
+
+	return CURLE_OK;
+
+error:
+	return code;
+}
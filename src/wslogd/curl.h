@@ -11,6 +11,8 @@ void curl_log(const char *fn, CURLcode code);
 
 CURLcode curl_easy_auth(CURL *h, const char *username, const char *pwd);
 CURLcode curl_easy_upload(CURL *h, const char *url, int fd);
+CURLcode curl_easy_small(CURL *h);
+CURLcode curl_easy_timeout(CURL *h);
 
 #ifdef __cplusplus
 }
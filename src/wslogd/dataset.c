@@ -337,6 +337,12 @@ ws_loop_wind_dir(const struct ws_loop *p, double *v)
 	return ws_get(p->wl_mask, WF_WIND_DIR, p->wind_dir, v);
 }
 
+int
+ws_loop_wind_10m_speed(const struct ws_loop *p, double *v)
+{
+	return ws_get(p->wl_mask, WF_10M_WIND_SPEED, p->wind_10m_speed, v);
+}
+
 int
 ws_loop_hi_wind_10m_speed(const struct ws_loop *p, double *v)
 {
@@ -361,6 +367,12 @@ ws_loop_rain_1h(const struct ws_loop *p, double *v)
 	return ws_get(p->wl_mask, WF_RAIN_1H, p->rain_1h, v);
 }
 
+int
+ws_loop_rain_24h(const struct ws_loop *p, double *v)
+{
+	return ws_get(p->wl_mask, WF_RAIN_24H, p->rain_24h, v);
+}
+
 int
 ws_loop_rain_rate(const struct ws_loop *p, double *v)
 {
@@ -409,6 +421,240 @@ ws_loop_in_humidity(const struct ws_loop *p, double *v)
 	return ws_get(p->wl_mask, WF_IN_HUMIDITY, p->in_humidity, v);
 }
 
+static int16_t
+pack_i16(double v, double scale)
+{
+	long l = lround(v * scale);
+
+	if (l < INT16_MIN) {
+		l = INT16_MIN;
+	} else if (l > INT16_MAX) {
+		l = INT16_MAX;
+	}
+
+	return l;
+}
+
+static uint16_t
+pack_u16(double v, double scale)
+{
+	long l = lround(v * scale);
+
+	if (l < 0) {
+		l = 0;
+	} else if (l > UINT16_MAX) {
+		l = UINT16_MAX;
+	}
+
+	return l;
+}
+
+/**
+ * Encode sensor data into its packed form.
+ *
+ * Values are rounded to the resolution of the packed field, and clamped to
+ * its range. Invalid fields (not in {@code wl_mask}) are zeroed.
+ */
+void
+ws_loop_pack(struct ws_loop_pack *dst, const struct ws_loop *src)
+{
+	memset(dst, 0, sizeof(*dst));
+
+	dst->time = (int64_t) src->time.tv_sec * 1000 + src->time.tv_nsec / 1000000;
+	dst->wl_mask = src->wl_mask;
+
+	if (src->wl_mask & WF_BAROMETER) {
+		dst->barometer = pack_u16(src->barometer, 10);
+	}
+	if (src->wl_mask & WF_TEMP) {
+		dst->temp = pack_i16(src->temp, 10);
+	}
+	if (src->wl_mask & WF_HUMIDITY) {
+		dst->humidity = src->humidity;
+	}
+	if (src->wl_mask & WF_WIND_SPEED) {
+		dst->wind_speed = pack_u16(src->wind_speed, 10);
+	}
+	if (src->wl_mask & WF_WIND_DIR) {
+		dst->wind_dir = src->wind_dir;
+	}
+	if (src->wl_mask & WF_10M_WIND_SPEED) {
+		dst->wind_10m_speed = pack_u16(src->wind_10m_speed, 10);
+	}
+	if (src->wl_mask & WF_HI_WIND_SPEED) {
+		dst->hi_wind_10m_speed = pack_u16(src->hi_wind_10m_speed, 10);
+	}
+	if (src->wl_mask & WF_HI_WIND_DIR) {
+		dst->hi_wind_10m_dir = src->hi_wind_10m_dir;
+	}
+	if (src->wl_mask & WF_RAIN_DAY) {
+		dst->rain_day = pack_u16(src->rain_day, 10);
+	}
+	if (src->wl_mask & WF_RAIN_RATE) {
+		dst->rain_rate = pack_u16(src->rain_rate, 10);
+	}
+	if (src->wl_mask & WF_RAIN_1H) {
+		dst->rain_1h = pack_u16(src->rain_1h, 10);
+	}
+	if (src->wl_mask & WF_RAIN_24H) {
+		dst->rain_24h = pack_u16(src->rain_24h, 10);
+	}
+	if (src->wl_mask & WF_SOLAR_RAD) {
+		dst->solar_rad = src->solar_rad;
+	}
+	if (src->wl_mask & WF_UV_INDEX) {
+		uint16_t uv = pack_u16(src->uv_idx, 10);
+
+		dst->uv_idx = uv > UINT8_MAX ? UINT8_MAX : uv;
+	}
+	if (src->wl_mask & WF_DEW_POINT) {
+		dst->dew_point = pack_i16(src->dew_point, 10);
+	}
+	if (src->wl_mask & WF_WINDCHILL) {
+		dst->windchill = pack_i16(src->windchill, 10);
+	}
+	if (src->wl_mask & WF_HEAT_INDEX) {
+		dst->heat_index = pack_i16(src->heat_index, 10);
+	}
+	if (src->wl_mask & WF_IN_TEMP) {
+		dst->in_temp = pack_i16(src->in_temp, 10);
+	}
+	if (src->wl_mask & WF_IN_HUMIDITY) {
+		dst->in_humidity = src->in_humidity;
+	}
+}
+
+/**
+ * Decode packed sensor data.
+ */
+void
+ws_loop_unpack(struct ws_loop *dst, const struct ws_loop_pack *src)
+{
+	memset(dst, 0, sizeof(*dst));
+
+	dst->time.tv_sec = src->time / 1000;
+	dst->time.tv_nsec = (src->time % 1000) * 1000000;
+	dst->wl_mask = src->wl_mask;
+
+	dst->barometer = src->barometer / 10.0;
+	dst->temp = src->temp / 10.0;
+	dst->humidity = src->humidity;
+	dst->wind_speed = src->wind_speed / 10.0;
+	dst->wind_dir = src->wind_dir;
+	dst->wind_10m_speed = src->wind_10m_speed / 10.0;
+	dst->hi_wind_10m_speed = src->hi_wind_10m_speed / 10.0;
+	dst->hi_wind_10m_dir = src->hi_wind_10m_dir;
+	dst->rain_day = src->rain_day / 10.0;
+	dst->rain_rate = src->rain_rate / 10.0;
+	dst->rain_1h = src->rain_1h / 10.0;
+	dst->rain_24h = src->rain_24h / 10.0;
+	dst->solar_rad = src->solar_rad;
+	dst->uv_idx = src->uv_idx / 10.0;
+	dst->dew_point = src->dew_point / 10.0;
+	dst->windchill = src->windchill / 10.0;
+	dst->heat_index = src->heat_index / 10.0;
+	dst->in_temp = src->in_temp / 10.0;
+	dst->in_humidity = src->in_humidity;
+}
+
+/**
+ * Encode archive data into its packed form.
+ *
+ * See {@code ws_loop_pack}.
+ */
+void
+ws_archive_pack(struct ws_archive_pack *dst, const struct ws_archive *src)
+{
+	memset(dst, 0, sizeof(*dst));
+
+	dst->time = src->time;
+	dst->interval = src->interval;
+	dst->wl_mask = src->wl_mask;
+
+	if (src->wl_mask & WF_BAROMETER) {
+		dst->barometer = pack_u16(src->barometer, 10);
+	}
+	if (src->wl_mask & WF_TEMP) {
+		dst->temp = pack_i16(src->temp, 10);
+	}
+	if (src->wl_mask & WF_HI_TEMP) {
+		dst->hi_temp = pack_i16(src->hi_temp, 10);
+	}
+	if (src->wl_mask & WF_LO_TEMP) {
+		dst->lo_temp = pack_i16(src->lo_temp, 10);
+	}
+	if (src->wl_mask & WF_HUMIDITY) {
+		dst->humidity = src->humidity;
+	}
+	if (src->wl_mask & WF_WIND_SPEED) {
+		dst->avg_wind_speed = pack_u16(src->avg_wind_speed, 10);
+	}
+	if (src->wl_mask & WF_WIND_DIR) {
+		dst->avg_wind_dir = src->avg_wind_dir;
+	}
+	if (src->wl_mask & WF_WIND_SAMPLES) {
+		dst->wind_samples = src->wind_samples;
+	}
+	if (src->wl_mask & WF_HI_WIND_SPEED) {
+		dst->hi_wind_speed = pack_u16(src->hi_wind_speed, 10);
+	}
+	if (src->wl_mask & WF_HI_WIND_DIR) {
+		dst->hi_wind_dir = src->hi_wind_dir;
+	}
+	if (src->wl_mask & WF_RAIN) {
+		dst->rain_fall = pack_u16(src->rain_fall, 100);
+	}
+	if (src->wl_mask & WF_HI_RAIN_RATE) {
+		dst->hi_rain_rate = pack_u16(src->hi_rain_rate, 10);
+	}
+	if (src->wl_mask & WF_DEW_POINT) {
+		dst->dew_point = pack_i16(src->dew_point, 10);
+	}
+	if (src->wl_mask & WF_WINDCHILL) {
+		dst->windchill = pack_i16(src->windchill, 10);
+	}
+	if (src->wl_mask & WF_HEAT_INDEX) {
+		dst->heat_index = pack_i16(src->heat_index, 10);
+	}
+	if (src->wl_mask & WF_IN_TEMP) {
+		dst->in_temp = pack_i16(src->in_temp, 10);
+	}
+	if (src->wl_mask & WF_IN_HUMIDITY) {
+		dst->in_humidity = src->in_humidity;
+	}
+}
+
+/**
+ * Decode packed archive data.
+ */
+void
+ws_archive_unpack(struct ws_archive *dst, const struct ws_archive_pack *src)
+{
+	memset(dst, 0, sizeof(*dst));
+
+	dst->time = src->time;
+	dst->interval = src->interval;
+	dst->wl_mask = src->wl_mask;
+
+	dst->barometer = src->barometer / 10.0;
+	dst->temp = src->temp / 10.0;
+	dst->hi_temp = src->hi_temp / 10.0;
+	dst->lo_temp = src->lo_temp / 10.0;
+	dst->humidity = src->humidity;
+	dst->avg_wind_speed = src->avg_wind_speed / 10.0;
+	dst->avg_wind_dir = src->avg_wind_dir;
+	dst->wind_samples = src->wind_samples;
+	dst->hi_wind_speed = src->hi_wind_speed / 10.0;
+	dst->hi_wind_dir = src->hi_wind_dir;
+	dst->rain_fall = src->rain_fall / 100.0;
+	dst->hi_rain_rate = src->hi_rain_rate / 10.0;
+	dst->dew_point = src->dew_point / 10.0;
+	dst->windchill = src->windchill / 10.0;
+	dst->heat_index = src->heat_index / 10.0;
+	dst->in_temp = src->in_temp / 10.0;
+	dst->in_humidity = src->in_humidity;
+}
+
 //static int
 //is_settable(const struct ws_archive *p, int mask, int flag)
 //{
@@ -144,6 +144,70 @@ struct ws_archive
 	uint8_t in_humidity;		/* Indoor humidity (%) */
 };
 
+/**
+ * Packed sensor data.
+ *
+ * Compact fixed-point encoding of {@code struct ws_loop}, used to store deep
+ * history. Fields are scaled integers: temperatures, pressures, speeds and
+ * rain are stored in tenth of units, with the same {@code wl_mask}.
+ */
+struct ws_loop_pack
+{
+	int64_t time;			/* Data time, in milliseconds */
+	uint32_t wl_mask;		/* Fields mask */
+
+	uint16_t barometer;		/* Barometer (0.1 hPa) */
+	int16_t temp;			/* Temperature (0.1 °C) */
+	uint16_t wind_speed;		/* Wind speed (0.1 m/s) */
+	uint16_t wind_dir;		/* Wind direction (°) */
+	uint16_t wind_10m_speed;	/* 10-minutes wind speed (0.1 m/s) */
+	uint16_t hi_wind_10m_speed;	/* 10-minutes wind gust speed (0.1 m/s) */
+	uint16_t hi_wind_10m_dir;	/* 10-minutes wind gust direction (°) */
+	uint16_t rain_day;		/* Daily rain (0.1 mm) */
+	uint16_t rain_rate;		/* Rain rate (0.1 mm/hr) */
+	uint16_t rain_1h;		/* Rain in the past hour (0.1 mm) */
+	uint16_t rain_24h;		/* Rain in the past 24 hours (0.1 mm) */
+	uint16_t solar_rad;		/* Solar radiation (W/m³) */
+	int16_t dew_point; 		/* Dew point (0.1 °C) */
+	int16_t windchill;		/* Windchill temperature (0.1 °C) */
+	int16_t heat_index;		/* Heat index (0.1 °C) */
+	int16_t in_temp;		/* Indoor temperature (0.1 °C) */
+	uint8_t uv_idx;			/* UV index (0.1) */
+	uint8_t humidity; 		/* Humidity (%) */
+	uint8_t in_humidity;		/* Indoor humidity (%) */
+};
+
+/**
+ * Packed archive data.
+ *
+ * See {@code struct ws_loop_pack}. Rain fall is stored in hundredth of
+ * millimeters.
+ */
+struct ws_archive_pack
+{
+	int64_t time;			/* Archive time */
+	uint32_t interval;		/* Archive interval, in seconds */
+	uint32_t wl_mask;		/* Fields mask */
+
+	uint16_t barometer;		/* Barometer (0.1 hPa) */
+	int16_t temp;			/* Temperature (0.1 °C) */
+	int16_t hi_temp;		/* High temperature (0.1 °C) */
+	int16_t lo_temp;		/* Low temperature (0.1 °C) */
+	uint16_t avg_wind_speed;	/* Wind speed (0.1 m/s) */
+	uint16_t avg_wind_dir;		/* Wind direction (°) */
+	uint16_t wind_samples;		/* Wind samples */
+	uint16_t hi_wind_speed;		/* High wind speed (0.1 m/s) */
+	uint16_t hi_wind_dir;		/* High wind direction (°) */
+	uint16_t rain_fall;		/* Sample rain fall (0.01 mm) */
+	uint16_t hi_rain_rate;		/* High rain rate (0.1 mm/hr) */
+	int16_t dew_point; 		/* Dew point (0.1 °C) */
+	int16_t windchill;		/* Windchill temperature (0.1 °C) */
+	int16_t heat_index;		/* Heat index (0.1 °C) */
+	int16_t in_temp;		/* Indoor temperature (0.1 °C) */
+	uint8_t humidity; 		/* Humidity (%) */
+	uint8_t in_humidity;		/* Indoor humidity (%) */
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -189,10 +253,12 @@ int ws_loop_temp(const struct ws_loop *p, double *v);
 int ws_loop_humidity(const struct ws_loop *p, double *v);
 int ws_loop_wind_speed(const struct ws_loop *p, double *v);
 int ws_loop_wind_dir(const struct ws_loop *p, double *v);
+int ws_loop_wind_10m_speed(const struct ws_loop *p, double *v);
 int ws_loop_hi_wind_10m_speed(const struct ws_loop *p, double *v);
 int ws_loop_hi_wind_10m_dir(const struct ws_loop *p, double *v);
 int ws_loop_rain_day(const struct ws_loop *p, double *v);
 int ws_loop_rain_1h(const struct ws_loop *p, double *v);
+int ws_loop_rain_24h(const struct ws_loop *p, double *v);
 int ws_loop_rain_rate(const struct ws_loop *p, double *v);
 int ws_loop_dew_point(const struct ws_loop *p, double *v);
 int ws_loop_windchill(const struct ws_loop *p, double *v);
@@ -202,6 +268,11 @@ int ws_loop_heat_index(const struct ws_loop *p, double *v);
 int ws_loop_in_temp(const struct ws_loop *p, double *v);
 int ws_loop_in_humidity(const struct ws_loop *p, double *v);
 
+void ws_loop_pack(struct ws_loop_pack *dst, const struct ws_loop *src);
+void ws_loop_unpack(struct ws_loop *dst, const struct ws_loop_pack *src);
+void ws_archive_pack(struct ws_archive_pack *dst, const struct ws_archive *src);
+void ws_archive_unpack(struct ws_archive *dst, const struct ws_archive_pack *src);
+
 void ws_calc(struct ws_archive *p);
 ssize_t ws_aggr(struct ws_archive *p, int freq);
 
@@ -2,7 +2,12 @@
 #include "config.h"
 #endif
 
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
@@ -14,13 +19,22 @@
 
 #include "board.h"
 #include "conf.h"
+#include "log.h"
 #include "wslogd.h"
 #include "sqlite.h"
 
 #define SQL_MAX		1024
+#define SQL_INSERT_MAX	8192
+#define SQL_PRAGMA_MAX	64
+#define SQL_BUSY	5000		/* Lock wait, in milliseconds */
 #define SQL_TABLE	"ws_archive"
 #define SQL_CREATE	"/usr/share/wslog/sqlite.sql"
 
+#define SMALL_CACHE	"-128"		/* Small profile page cache, in kB */
+#define SMALL_HEAP	(1024 * 1024)	/* Small profile heap soft limit */
+#define SMALL_SLOT	64		/* Small profile lookaside slot size */
+#define SMALL_NSLOT	16		/* Small profile lookaside slots */
+
 #define bufsz(buf, p, len) ((len) - ((p) - (buf)))
 
 struct ws_db
@@ -32,8 +46,20 @@ struct ws_db
 	int ignore;
 };
 
+/*
+ * Records are inserted by batches, with multi-row INSERT statements. One
+ * statement is prepared for each batch size; a batch of records is split
+ * into the largest batches first. Rows per statement are bounded by the
+ * number of host parameters (999 in older SQLite releases).
+ */
+static const size_t batch_sizes[] = { 16, 4, 1 };
+
+#define BATCH_MAX 16			/* Largest batch size */
+#define BATCH_NEL array_size(batch_sizes)
+
 static sqlite3 *db;			/* Database handle */
-static sqlite3_stmt *stmt;		/* Insert prepared statement */
+static atomic_int wal_pages;		/* Pages in the write-ahead log */
+static sqlite3_stmt *stmts[BATCH_NEL];	/* Insert prepared statements */
 
 static const struct ws_db columns[] =
 {
@@ -60,10 +86,23 @@ static const struct ws_db columns[] =
 
 static size_t columns_nel = array_size(columns);
 
+_Static_assert(array_size(columns) <= 32, "too many columns");
+
+/**
+ * Decoded record, ready to be bound.
+ */
+struct sql_row
+{
+	sqlite3_int64 time;		/* Record time */
+	int interval;			/* Record interval */
+	uint32_t valid;			/* Valid columns */
+	double value[array_size(columns)];
+};
+
 static void
 sqlite_log(const char *fn, int code)
 {
-	syslog(LOG_ERR, "%s: %s (%d)", fn, sqlite3_errstr(code), code);
+	log_msg(LOG_ERR, "%s: %s (%d)", fn, sqlite3_errstr(code), code);
 }
 
 static char *
@@ -90,7 +129,7 @@ sql_create(char *buf, size_t len)
 	const char* sqlfile = SQL_CREATE;
 
 	if ((sz = ws_read_all(sqlfile, buf, len)) == -1) {
-		syslog(LOG_ERR, "ws_read_all %s: %m", sqlfile);
+		log_msg(LOG_ERR, "ws_read_all %s: %m", sqlfile);
 		goto error;
 	}
 
@@ -103,27 +142,32 @@ error:
 }
 
 static ssize_t
-sql_insert(char *buf, size_t len)
+sql_insert(char *buf, size_t len, size_t nrows)
 {
 	int i;
+	size_t row;
 	char *p = buf;
 
 	p = stpncpy(p, "INSERT INTO " SQL_TABLE " (", bufsz(buf, p, len));
 
 	p = sql_columns(p, bufsz(buf, p, len));
 
-	p = stpncpy(p, ") VALUES (", bufsz(buf, p, len));
+	p = stpncpy(p, ") VALUES ", bufsz(buf, p, len));
 
-	for (i = 0; i < columns_nel; i++) {
-		if (i > 0) {
-			p = stpncpy(p, ", ", bufsz(buf, p, len));
+	for (row = 0; row < nrows; row++) {
+		p = stpncpy(p, row > 0 ? ", (" : "(", bufsz(buf, p, len));
+
+		for (i = 0; i < columns_nel; i++) {
+			if (i > 0) {
+				p = stpncpy(p, ", ", bufsz(buf, p, len));
+			}
+
+			p = stpncpy(p, "?", bufsz(buf, p, len));
 		}
 
-		p = stpncpy(p, "?", bufsz(buf, p, len));
+		p = stpncpy(p, ")", bufsz(buf, p, len));
 	}
 
-	p = stpncpy(p, ")", bufsz(buf, p, len));
-
 	return p - buf;
 }
 
@@ -140,7 +184,7 @@ sql_select(char *buf, size_t len)
 }
 
 static int
-sqlite_step()
+sqlite_step(sqlite3_stmt *stmt)
 {
 	int ret;
 	int reset = 1;
@@ -166,55 +210,82 @@ error:
 	return -1;
 }
 
-static int
-sqlite_stmt_insert(const struct ws_archive *p)
+/**
+ * Decodes the record {@code p}: column values are fetched and rounded once,
+ * before binding.
+ */
+static void
+sql_decode(struct sql_row *row, const struct ws_archive *p)
 {
-	int ret;
-	int i, bind_index;
+	int i;
 
-	/* Bind variables */
-	bind_index = 1;
-
-	ret = sqlite3_bind_int64(stmt, bind_index++, p->time);
-	if (SQLITE_OK != ret) {
-		sqlite_log("sqlite3_bind_int64", ret);
-		goto error;
-	}
-	ret = sqlite3_bind_int(stmt, bind_index++, p->interval);
-	if (SQLITE_OK != ret) {
-		sqlite_log("sqlite3_bind_int", ret);
-		goto error;
-	}
+	row->time = p->time;
+	row->interval = p->interval;
+	row->valid = 0;
 
 	for (i = 2; i < columns_nel; i++) {
 		double value;
 
 		if (columns[i].get(p, &value) == 0) {
-			switch (columns[i].col_type) {
-			case SQLITE_INTEGER:
-				ret = sqlite3_bind_int(stmt, bind_index, value);
-				break;
-			case SQLITE_FLOAT:
-				ret = sqlite3_bind_double(stmt, bind_index, round_scale(value, 2));
-				break;
-			default:
-				break;
+			if (columns[i].col_type == SQLITE_FLOAT) {
+				value = round_scale(value, 2);
 			}
-		} else {
-			ret = sqlite3_bind_null(stmt, bind_index);
+
+			row->value[i] = value;
+			row->valid |= 1U << i;
 		}
+	}
+}
+
+/**
+ * Binds the {@code nrows} decoded rows to the statement {@code stmt}, and
+ * executes it.
+ */
+static int
+sqlite_stmt_insert(sqlite3_stmt *stmt, const struct sql_row *rows, size_t nrows)
+{
+	int ret;
+	int i, bind_index;
+	size_t row;
+
+	/* Bind variables */
+	bind_index = 1;
+
+	for (row = 0; row < nrows; row++) {
+		const struct sql_row *p = &rows[row];
 
+		ret = sqlite3_bind_int64(stmt, bind_index++, p->time);
 		if (SQLITE_OK != ret) {
-			sqlite_log("sqlite3_bind_xx", ret);
+			sqlite_log("sqlite3_bind_int64", ret);
 			goto error;
 		}
+		ret = sqlite3_bind_int(stmt, bind_index++, p->interval);
+		if (SQLITE_OK != ret) {
+			sqlite_log("sqlite3_bind_int", ret);
+			goto error;
+		}
+
+		for (i = 2; i < columns_nel; i++) {
+			if (!(p->valid & (1U << i))) {
+				ret = sqlite3_bind_null(stmt, bind_index);
+			} else if (columns[i].col_type == SQLITE_INTEGER) {
+				ret = sqlite3_bind_int(stmt, bind_index, p->value[i]);
+			} else {
+				ret = sqlite3_bind_double(stmt, bind_index, p->value[i]);
+			}
 
-		bind_index++;
+			if (SQLITE_OK != ret) {
+				sqlite_log("sqlite3_bind_xx", ret);
+				goto error;
+			}
+
+			bind_index++;
+		}
 	}
 
 	/* Execute statement */
 	if (!dry_run) {
-		if (sqlite_step() == -1) {
+		if (sqlite_step(stmt) == -1) {
 			goto error;
 		}
 	}
@@ -239,18 +310,158 @@ sqlite_exec(const char *stmt)
 	return 0;
 }
 
+/**
+ * Caps the memory used by the connection, for the small profile. Settings
+ * are per connection, so that they also apply when the daemon restarts.
+ */
+static int
+sqlite_small(void)
+{
+	int ret;
+
+	ret = sqlite3_db_config(db, SQLITE_DBCONFIG_LOOKASIDE, NULL, SMALL_SLOT, SMALL_NSLOT);
+	if (ret != SQLITE_OK) {
+		sqlite_log("sqlite3_db_config", ret);
+		goto error;
+	}
+
+	ret = sqlite3_exec(db, "PRAGMA cache_size = " SMALL_CACHE, NULL, NULL, NULL);
+	if (ret != SQLITE_OK) {
+		sqlite_log("sqlite3_exec", ret);
+		goto error;
+	}
+
+	return 0;
+
+error:
+	return -1;
+}
+
+/**
+ * Sets the pragma {@code name}. For the journal mode, the mode in effect is
+ * checked, since SQLite keeps the current mode when the requested one is not
+ * available.
+ */
+static int
+sqlite_pragma(const char *name, const char *fmt, ...)
+{
+	int ret;
+	va_list ap;
+	char value[SQL_PRAGMA_MAX];
+	char sqlbuf[SQL_PRAGMA_MAX * 2];
+	sqlite3_stmt *query;
+
+	va_start(ap, fmt);
+	(void) vsnprintf(value, sizeof(value), fmt, ap);
+	va_end(ap);
+
+	snprintf(sqlbuf, sizeof(sqlbuf), "PRAGMA %s = %s", name, value);
+
+	ret = sqlite3_prepare_v2(db, sqlbuf, -1, &query, NULL);
+	if (ret != SQLITE_OK) {
+		sqlite_log("sqlite3_prepare_v2", ret);
+		goto error;
+	}
+
+	while ((ret = sqlite3_step(query)) == SQLITE_ROW) {
+		const char *mode = (const char *) sqlite3_column_text(query, 0);
+
+		if (!strcmp(name, "journal_mode") && mode && strcasecmp(mode, value)) {
+			log_msg(LOG_WARNING, "sqlite: journal_mode %s not available, using %s",
+					value, mode);
+		}
+	}
+
+	if (ret != SQLITE_DONE) {
+		sqlite_log("sqlite3_step", ret);
+		goto error;
+	}
+
+	(void) sqlite3_finalize(query);
+
+	return 0;
+
+error:
+	(void) sqlite3_finalize(query);
+	return -1;
+}
+
+/**
+ * Tracks the write-ahead log size, in place of the automatic checkpoint:
+ * checkpoints are run in background by the caller (see sqlite_checkpoint()).
+ */
+static int
+sqlite_wal_hook(void *arg, sqlite3 *h, const char *name, int npages)
+{
+	(void) arg;
+	(void) h;
+	(void) name;
+
+	atomic_store_explicit(&wal_pages, npages, memory_order_relaxed);
+
+	return SQLITE_OK;
+}
+
+/**
+ * Applies the configured pragmas.
+ */
+static int
+sqlite_pragmas(void)
+{
+	const struct ws_conf *cfg = confp;
+
+	if (cfg->archive.sqlite.journal_mode) {
+		if (sqlite_pragma("journal_mode", "%s", cfg->archive.sqlite.journal_mode) == -1) {
+			goto error;
+		}
+	}
+	if (cfg->archive.sqlite.synchronous) {
+		if (sqlite_pragma("synchronous", "%s", cfg->archive.sqlite.synchronous) == -1) {
+			goto error;
+		}
+	}
+	if (cfg->archive.sqlite.temp_store) {
+		if (sqlite_pragma("temp_store", "%s", cfg->archive.sqlite.temp_store) == -1) {
+			goto error;
+		}
+	}
+	if (cfg->archive.sqlite.cache_size) {
+		if (sqlite_pragma("cache_size", "%ld", -cfg->archive.sqlite.cache_size) == -1) {
+			goto error;
+		}
+	}
+	if (cfg->archive.sqlite.mmap_size) {
+		if (sqlite_pragma("mmap_size", "%ld", cfg->archive.sqlite.mmap_size * 1024) == -1) {
+			goto error;
+		}
+	}
+
+	/* Background checkpoints */
+	atomic_store(&wal_pages, 0);
+
+	if (cfg->archive.sqlite.checkpoint > 0) {
+		(void) sqlite3_wal_hook(db, sqlite_wal_hook, NULL);
+	}
+
+	return 0;
+
+error:
+	return -1;
+}
+
 int
 sqlite_init(void)
 {
 	int sz, ret;
+	size_t i;
 	struct stat sbuf;
 	int oflag = 0;
-	char sqlbuf[SQL_MAX];
+	char sqlbuf[SQL_INSERT_MAX];
 	const char *dbfile = confp->archive.sqlite.db;
 
 	/* Clear */
 	db = NULL;
-	stmt = NULL;
+	memset(stmts, 0, sizeof(stmts));
 
 	ret = sqlite3_initialize();
 	if (ret != SQLITE_OK) {
@@ -264,7 +475,7 @@ sqlite_init(void)
 		if (errno == ENOENT) {
 			oflag |= SQLITE_OPEN_CREATE;
 		} else {
-			syslog(LOG_ERR, "stat %s: %m", dbfile);
+			log_msg(LOG_ERR, "stat %s: %m", dbfile);
 			goto error;
 		}
 	}
@@ -273,7 +484,24 @@ sqlite_init(void)
 
 	ret = sqlite3_open_v2(dbfile, &db, oflag, NULL);
 	if (ret != SQLITE_OK) {
-		syslog(LOG_ERR, "sqlite3_open_v2 %s: %s", dbfile, sqlite3_errstr(ret));
+		log_msg(LOG_ERR, "sqlite3_open_v2 %s: %s", dbfile, sqlite3_errstr(ret));
+		goto error;
+	}
+
+	/* Memory profile */
+	if (confp->worker.profile == PROFILE_SMALL) {
+		if (sqlite_small() == -1) {
+			goto error;
+		}
+
+		(void) sqlite3_soft_heap_limit64(SMALL_HEAP);
+	} else {
+		(void) sqlite3_soft_heap_limit64(0);
+	}
+
+	(void) sqlite3_busy_timeout(db, SQL_BUSY);
+
+	if (sqlite_pragmas() == -1) {
 		goto error;
 	}
 
@@ -290,20 +518,26 @@ sqlite_init(void)
 		}
 	}
 
-	/* Prepare statement */
-	sz = sql_insert(sqlbuf, sizeof(sqlbuf));
+	/* Prepare statements */
+	for (i = 0; i < BATCH_NEL; i++) {
+		sz = sql_insert(sqlbuf, sizeof(sqlbuf), batch_sizes[i]);
 
-	ret = sqlite3_prepare_v2(db, sqlbuf, sz, &stmt, NULL);
-	if (ret != SQLITE_OK) {
-		sqlite_log("sqlite3_prepare_v2", ret);
-		goto error;
+		ret = sqlite3_prepare_v2(db, sqlbuf, sz, &stmts[i], NULL);
+		if (ret != SQLITE_OK) {
+			sqlite_log("sqlite3_prepare_v2", ret);
+			goto error;
+		}
 	}
 
-	syslog(LOG_INFO, "sqlite %s: connected", dbfile);
+	log_msg(LOG_INFO, "sqlite %s: connected", dbfile);
 
 	return 0;
 
 error:
+	for (i = 0; i < BATCH_NEL; i++) {
+		(void) sqlite3_finalize(stmts[i]);
+		stmts[i] = NULL;
+	}
 	if (db != NULL) {
 		(void) sqlite3_close_v2(db);
 		db = NULL;
@@ -316,13 +550,17 @@ sqlite_destroy(void)
 {
 	int ret;
 	int status;
+	size_t i;
 
 	status = 0;
 
-	ret = sqlite3_finalize(stmt);
-	if (ret != SQLITE_OK) {
-		status = -1;
-		sqlite_log("sqlite3_finalize", ret);
+	for (i = 0; i < BATCH_NEL; i++) {
+		ret = sqlite3_finalize(stmts[i]);
+		if (ret != SQLITE_OK) {
+			status = -1;
+			sqlite_log("sqlite3_finalize", ret);
+		}
+		stmts[i] = NULL;
 	}
 
 	if (db != NULL) {
@@ -342,6 +580,37 @@ sqlite_destroy(void)
 	return status;
 }
 
+/**
+ * Returns the number of pages in the write-ahead log, not checkpointed yet.
+ * Always 0 when background checkpoints are disabled.
+ */
+int
+sqlite_wal_pages(void)
+{
+	return atomic_load_explicit(&wal_pages, memory_order_relaxed);
+}
+
+/**
+ * Copies the write-ahead log pages back into the database, without waiting
+ * for readers.
+ */
+int
+sqlite_checkpoint(void)
+{
+	int ret;
+	int nlog, nckpt;
+
+	ret = sqlite3_wal_checkpoint_v2(db, NULL, SQLITE_CHECKPOINT_PASSIVE, &nlog, &nckpt);
+	if (ret != SQLITE_OK) {
+		sqlite_log("sqlite3_wal_checkpoint_v2", ret);
+		return -1;
+	}
+
+	atomic_store_explicit(&wal_pages, nlog - nckpt, memory_order_relaxed);
+
+	return 0;
+}
+
 int
 sqlite_begin()
 {
@@ -360,13 +629,28 @@ sqlite_rollback()
 	return sqlite_exec("ROLLBACK");
 }
 
+/**
+ * Inserts {@code nel} records, by batches of decreasing size.
+ */
 ssize_t
 sqlite_insert(const struct ws_archive *p, size_t nel)
 {
-	size_t i;
+	size_t i, j, k, n;
+	struct sql_row rows[BATCH_MAX];
+
+	for (i = 0; i < nel; i += n) {
+		/* Largest batch */
+		for (k = 0; batch_sizes[k] > nel - i; k++) {
+			;
+		}
+
+		n = batch_sizes[k];
+
+		for (j = 0; j < n; j++) {
+			sql_decode(&rows[j], &p[i + j]);
+		}
 
-	for (i = 0; i < nel; i++) {
-		if (sqlite_stmt_insert(&p[i]) == -1) {
+		if (sqlite_stmt_insert(stmts[k], rows, n) == -1) {
 			goto error;
 		}
 	}
@@ -18,6 +18,9 @@ int sqlite_begin();
 int sqlite_commit();
 int sqlite_rollback();
 
+int sqlite_wal_pages(void);
+int sqlite_checkpoint(void);
+
 ssize_t sqlite_insert(const struct ws_archive *p, size_t nel);
 ssize_t sqlite_select_last(struct ws_archive *p, size_t nel);
 
@@ -14,6 +14,7 @@
 #include "service/util.h"
 #include "driver/vantage.h"
 #include "conf.h"
+#include "log.h"
 
 #define ARCHIVE_DELAY	15		/* Delay before fetching new record */
 
@@ -32,14 +33,14 @@ vantage_lock(int fd)
 	locked = 0;
 
 	if (flock(fd, LOCK_EX) == -1) {
-		syslog(LOG_ERR, "flock (ex): %m");
+		log_msg(LOG_ERR, "flock (ex): %m");
 		goto error;
 	}
 
 	locked++;
 
 	if (pthread_mutex_lock(&mutex) == -1) {
-		syslog(LOG_ERR, "pthread_mutex_lock: %m");
+		log_msg(LOG_ERR, "pthread_mutex_lock: %m");
 		goto error;
 	}
 
@@ -47,7 +48,7 @@ vantage_lock(int fd)
 
 	/* Wakeup console */
 	if (vantage_wakeup(fd) == -1) {
-		syslog(LOG_ERR, "vantage_wakeup: %m");
+		log_msg(LOG_ERR, "vantage_wakeup: %m");
 		goto error;
 	}
 
@@ -68,11 +69,11 @@ static int
 vantage_unlock(int fd)
 {
 	if (pthread_mutex_unlock(&mutex) == -1) {
-		syslog(LOG_ERR, "pthread_mutex_unlock: %m");
+		log_msg(LOG_ERR, "pthread_mutex_unlock: %m");
 		goto error;
 	}
 	if (flock(fd, LOCK_UN) == -1) {
-		syslog(LOG_ERR, "flock (un): %m");
+		log_msg(LOG_ERR, "flock (un): %m");
 		goto error;
 	}
 
@@ -225,13 +226,13 @@ vantage_init(void)
 	const char *tty = confp->driver.vantage.tty;
 
 	if (pthread_mutex_init(&mutex, NULL) == -1) {
-		syslog(LOG_ERR, "pthread_mutex_init: %m");
+		log_msg(LOG_ERR, "pthread_mutex_init: %m");
 		goto error;
 	}
 
 	/* Open device */
 	if ((fd = vantage_open(tty)) == -1) {
-		syslog(LOG_ERR, "vantage_open %s: %m", tty);
+		log_msg(LOG_ERR, "vantage_open %s: %m", tty);
 		goto error;
 	}
 
@@ -241,11 +242,11 @@ vantage_init(void)
 
 	/* Read console configuration */
 	if (vantage_wrd(fd, &wrd) == -1) {
-		syslog(LOG_ERR, "vantage_wrd: %m");
+		log_msg(LOG_ERR, "vantage_wrd: %m");
 		goto error;
 	}
 	if (vantage_ee_cfg(fd, &cfg) == -1) {
-		syslog(LOG_ERR, "vantage_ee_cfg: %m");
+		log_msg(LOG_ERR, "vantage_ee_cfg: %m");
 		goto error;
 	}
 
@@ -254,7 +255,7 @@ vantage_init(void)
 		goto error;
 	}
 
-	syslog(LOG_NOTICE, "%s initialized", vantage_type_str(wrd));
+	log_msg(LOG_NOTICE, "%s initialized", vantage_type_str(wrd));
 
 	return 0;
 
@@ -270,7 +271,7 @@ int
 vantage_destroy(void)
 {
 	if (vantage_close(fd) == -1) {
-		syslog(LOG_ERR, "vantage_close: %m");
+		log_msg(LOG_ERR, "vantage_close: %m");
 		goto error;
 	}
 
@@ -290,7 +291,7 @@ vantage_get_rt(struct ws_loop *p)
 	}
 
 	if (vantage_lps(fd, LPS_LOOP2, &lbuf, 1) == -1) {
-		syslog(LOG_ERR, "vantage_lps: %m");
+		log_msg(LOG_ERR, "vantage_lps: %m");
 		goto error;
 	}
 
@@ -331,7 +332,7 @@ vantage_get_ar(struct ws_archive *p, size_t nel, time_t after)
 	}
 
 	if ((sz = vantage_dmpaft(fd, buf, nel, after)) == -1) {
-		syslog(LOG_ERR, "vantage_dmpaft: %m");
+		log_msg(LOG_ERR, "vantage_dmpaft: %m");
 		goto error;
 	}
 
@@ -364,7 +365,7 @@ vantage_get_ar_itimer(struct itimerspec *it)
 //		}
 //
 //		localftime_r(ftime, sizeof(ftime), &current, "%F %R");
-//		syslog(LOG_NOTICE, "last archive: %s", ftime);
+//		log_msg(LOG_NOTICE, "last archive: %s", ftime);
 
 	// TODO: check that archives are generated at rounded timestamps
 	itimer_setdelay(it, cfg.ar_period * 60, ARCHIVE_DELAY);
@@ -380,7 +381,7 @@ vantage_time(time_t *time)
 	}
 
 	if (vantage_gettime(fd, time) == -1) {
-		syslog(LOG_ERR, "vantage_gettime: %m");
+		log_msg(LOG_ERR, "vantage_gettime: %m");
 		goto error;
 	}
 
@@ -400,7 +401,7 @@ vantage_adjtime(time_t time)
 	}
 
 	if (vantage_settime(fd, time) == -1) {
-		syslog(LOG_ERR, "vantage_settime: %m");
+		log_msg(LOG_ERR, "vantage_settime: %m");
 		goto error;
 	}
 
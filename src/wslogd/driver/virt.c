@@ -10,6 +10,7 @@
 #include "libws/defs.h"
 
 #include "conf.h"
+#include "log.h"
 #include "service/util.h"
 #include "driver/driver.h"
 #include "driver/virt.h"
@@ -100,7 +101,7 @@ virt_init(void)
 		return -1;
 	}
 
-	syslog(LOG_NOTICE, "Simulator device initialized");
+	log_msg(LOG_NOTICE, "Simulator device initialized");
 
 	return 0;
 }
@@ -189,7 +190,7 @@ virt_adjtime(time_t t)
 	}
 
 	errno = ENOTSUP;
-	syslog(LOG_WARNING, "Virtual device: %m");
+	log_msg(LOG_WARNING, "Virtual device: %m");
 
 	return -1;
 }
@@ -16,6 +16,7 @@
 #include "libws/ws23xx/ws23xx.h"
 
 #include "conf.h"
+#include "log.h"
 #include "ws23xx.h"
 
 #define WF_ALL_IN	(WF_IN_TEMP|WF_IN_HUMIDITY|WF_PRESSURE|WF_BAROMETER)
@@ -115,7 +116,7 @@ ws23xx_hw_limits(struct ws_loop *p, int log)
 	if (log && prev_mask != p->wl_mask) {
 		uint32_t diff_mask = prev_mask ^ p->wl_mask;
 
-		syslog(LOG_WARNING, "Unexpected sensor values (%x mask)", diff_mask);
+		log_msg(LOG_WARNING, "Unexpected sensor values (%x mask)", diff_mask);
 	}
 }
 
@@ -237,7 +238,7 @@ ws23xx_get_rt(struct ws_loop *p)
 		break;
 
 	default:
-		syslog(LOG_WARNING, "Connection: %x lost", cnx_type);
+		log_msg(LOG_WARNING, "Connection: %x lost", cnx_type);
 		break;
 	}
 
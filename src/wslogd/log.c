@@ -0,0 +1,364 @@
+/*
+ * Asynchronous logging.
+ *
+ * Messages are formatted by the calling thread, and pushed to a bounded
+ * lock-free ring (multiple producers, single consumer). A drain thread pops
+ * them and writes them to syslog, so that a stalled syslog daemon never
+ * blocks the sampling threads.
+ *
+ * Each slot holds a sequence number: a producer claims the slot at the tail
+ * with a compare-and-swap, copies the message in, and publishes the slot by
+ * moving its sequence (release). The consumer frees the slot by moving its
+ * sequence one lap ahead. When the ring is full, or the rate limit is hit,
+ * the message is dropped and counted.
+ *
+ * The drain thread folds consecutive identical messages, and reports the
+ * dropped messages, at most once every LOG_FLUSH seconds.
+ *
+ * Until the ring is opened, messages are written to syslog directly.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <syslog.h>
+#include <time.h>
+#include <errno.h>
+
+#include "log.h"
+
+#define LOG_SLOTS 64			/* Ring slots (power of 2) */
+#define LOG_LEN 256			/* Max message length */
+#define LOG_RATE 100			/* Max messages per second */
+#define LOG_FLUSH 10			/* Repeat and drop report period */
+
+struct log_slot
+{
+	atomic_size_t seq;		/* Sequence number */
+	int priority;			/* Message priority */
+	char msg[LOG_LEN];		/* Message */
+};
+
+struct log_entry
+{
+	int priority;			/* Message priority */
+	char msg[LOG_LEN];		/* Message */
+};
+
+static struct log_slot ring[LOG_SLOTS];
+static atomic_size_t tail;		/* Producers position */
+static size_t head;			/* Consumer position */
+
+static sem_t sem;			/* Drain thread wakeup */
+static pthread_t tid;			/* Drain thread */
+static atomic_int running;		/* Ring opened */
+static atomic_int stopping;		/* Drain thread stop request */
+
+static atomic_int logmask = 0xff;		/* Priority mask */
+static atomic_uint_fast64_t rate;	/* Rate limit second and count */
+
+static atomic_ulong logged;
+static atomic_ulong repeated;
+static atomic_ulong dropped;
+
+static int
+log_rate(void)
+{
+	uint_fast64_t old, new;
+	uint32_t now = (uint32_t) time(NULL);
+
+	old = atomic_load_explicit(&rate, memory_order_relaxed);
+	do {
+		if ((old >> 32) == now) {
+			if ((old & UINT32_MAX) >= LOG_RATE) {
+				return 0;
+			}
+			new = old + 1;
+		} else {
+			new = ((uint_fast64_t) now << 32) | 1;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&rate, &old, new,
+			memory_order_relaxed, memory_order_relaxed));
+
+	return 1;
+}
+
+static int
+log_push(int priority, const char *msg)
+{
+	struct log_slot *s;
+	size_t pos;
+
+	pos = atomic_load_explicit(&tail, memory_order_relaxed);
+	for (;;) {
+		size_t seq;
+
+		s = &ring[pos % LOG_SLOTS];
+		seq = atomic_load_explicit(&s->seq, memory_order_acquire);
+
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit(&tail, &pos, pos + 1,
+					memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if ((intptr_t) (seq - pos) < 0) {
+			return -1;		/* Full */
+		} else {
+			pos = atomic_load_explicit(&tail, memory_order_relaxed);
+		}
+	}
+
+	s->priority = priority;
+	memcpy(s->msg, msg, strlen(msg) + 1);
+	atomic_store_explicit(&s->seq, pos + 1, memory_order_release);
+
+	return 0;
+}
+
+static int
+log_pop(struct log_entry *p)
+{
+	struct log_slot *s = &ring[head % LOG_SLOTS];
+
+	if (atomic_load_explicit(&s->seq, memory_order_acquire) != head + 1) {
+		return 0;
+	}
+
+	p->priority = s->priority;
+	memcpy(p->msg, s->msg, sizeof(p->msg));
+	atomic_store_explicit(&s->seq, head + LOG_SLOTS, memory_order_release);
+	head++;
+
+	return 1;
+}
+
+static void
+log_repeat(const struct log_entry *last, unsigned long *nrepeat)
+{
+	if (*nrepeat > 0) {
+		syslog(last->priority, "last message repeated %lu times", *nrepeat);
+		atomic_fetch_add_explicit(&repeated, *nrepeat, memory_order_relaxed);
+		*nrepeat = 0;
+	}
+}
+
+static time_t
+log_now(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec;
+}
+
+static void *
+log_main(void *arg)
+{
+	struct log_entry cur, last;
+	unsigned long nrepeat, ndropped, reported;
+	time_t now, repeat_time, report_time;
+
+	(void) arg;
+
+	last.priority = -1;
+	nrepeat = 0;
+	reported = 0;
+	repeat_time = 0;
+	report_time = 0;
+
+	for (;;) {
+		int stop = atomic_load_explicit(&stopping, memory_order_acquire);
+
+		now = log_now();
+
+		while (log_pop(&cur)) {
+			if (cur.priority == last.priority && strcmp(cur.msg, last.msg) == 0) {
+				if (nrepeat++ == 0) {
+					repeat_time = now;
+				}
+				continue;
+			}
+
+			log_repeat(&last, &nrepeat);
+			syslog(cur.priority, "%s", cur.msg);
+			atomic_fetch_add_explicit(&logged, 1, memory_order_relaxed);
+			last = cur;
+		}
+
+		if (nrepeat > 0 && (stop || LOG_FLUSH <= now - repeat_time)) {
+			log_repeat(&last, &nrepeat);
+		}
+
+		ndropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+		if (ndropped != reported && (stop || LOG_FLUSH <= now - report_time)) {
+			syslog(LOG_WARNING, "%lu log messages dropped", ndropped - reported);
+			reported = ndropped;
+			report_time = now;
+		}
+
+		if (stop) {
+			break;
+		}
+
+		/* Wait for messages, or for pending reports */
+		if (nrepeat > 0 || ndropped != reported) {
+			struct timespec ts;
+
+			(void) clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec++;
+
+			while (sem_timedwait(&sem, &ts) == -1 && errno == EINTR) {
+				;
+			}
+		} else {
+			while (sem_wait(&sem) == -1 && errno == EINTR) {
+				;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Opens the connection to syslog, and starts the drain thread.
+ *
+ * When already opened, only the connection is reopened.
+ */
+int
+log_open(const char *ident, int facility)
+{
+	size_t i;
+	int ret;
+	sigset_t set, oset;
+
+	openlog(ident, LOG_PID, facility);
+
+	if (atomic_load(&running)) {
+		return 0;
+	}
+
+	for (i = 0; i < LOG_SLOTS; i++) {
+		atomic_init(&ring[i].seq, i);
+	}
+	atomic_init(&tail, 0);
+	head = 0;
+	atomic_init(&stopping, 0);
+
+	if (sem_init(&sem, 0, 0) == -1) {
+		syslog(LOG_ERR, "sem_init: %m");
+		goto error;
+	}
+
+	/* Signals are handled by other threads */
+	(void) sigfillset(&set);
+	(void) pthread_sigmask(SIG_SETMASK, &set, &oset);
+
+	ret = pthread_create(&tid, NULL, log_main, NULL);
+
+	(void) pthread_sigmask(SIG_SETMASK, &oset, NULL);
+
+	if (ret != 0) {
+		errno = ret;
+		syslog(LOG_ERR, "pthread_create: %m");
+		goto error;
+	}
+
+	atomic_store(&running, 1);
+
+	return 0;
+
+error:
+	(void) sem_destroy(&sem);
+	return -1;
+}
+
+/**
+ * Stops the drain thread, once pending messages are written, and closes the
+ * connection to syslog.
+ */
+void
+log_close(void)
+{
+	if (atomic_exchange(&running, 0)) {
+		atomic_store_explicit(&stopping, 1, memory_order_release);
+		(void) sem_post(&sem);
+		(void) pthread_join(tid, NULL);
+		(void) sem_destroy(&sem);
+	}
+
+	closelog();
+}
+
+/**
+ * Sets the priority mask, and returns the previous one. If {@code mask} is
+ * 0, the mask is not modified.
+ */
+int
+log_setmask(int mask)
+{
+	if (mask == 0) {
+		return atomic_load(&logmask);
+	}
+
+	(void) setlogmask(mask);
+
+	return atomic_exchange(&logmask, mask);
+}
+
+/**
+ * Logs a message, without blocking.
+ *
+ * The message is formatted as {@code syslog} does, and truncated to LOG_LEN
+ * bytes. The {@code errno} value is preserved.
+ */
+void
+log_msg(int priority, const char *fmt, ...)
+{
+	va_list ap;
+	int errsv = errno;
+	char buf[LOG_LEN];
+
+	if (!(LOG_MASK(LOG_PRI(priority)) & atomic_load_explicit(&logmask, memory_order_relaxed))) {
+		return;
+	}
+
+	va_start(ap, fmt);
+
+	if (!atomic_load_explicit(&running, memory_order_acquire)) {
+		vsyslog(priority, fmt, ap);
+	} else {
+		(void) vsnprintf(buf, sizeof(buf), fmt, ap);
+
+		if (!log_rate() || log_push(priority, buf) == -1) {
+			atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+		} else {
+			(void) sem_post(&sem);
+		}
+	}
+
+	va_end(ap);
+
+	errno = errsv;
+}
+
+/**
+ * Takes a snapshot of the logging counters.
+ */
+void
+log_stats(struct log_stats *p)
+{
+	p->logged = atomic_load_explicit(&logged, memory_order_relaxed);
+	p->repeated = atomic_load_explicit(&repeated, memory_order_relaxed);
+	p->dropped = atomic_load_explicit(&dropped, memory_order_relaxed);
+}
@@ -0,0 +1,37 @@
+#ifndef _LOG_H
+#define _LOG_H
+
+#include <syslog.h>
+
+/*
+ * Asynchronous logging.
+ */
+
+/**
+ * Logging counters.
+ */
+struct log_stats
+{
+	unsigned long logged;		/* Messages written to syslog */
+	unsigned long repeated;		/* Repeated messages folded */
+	unsigned long dropped;		/* Messages dropped */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int log_open(const char *ident, int facility);
+void log_close(void);
+int log_setmask(int mask);
+
+void log_msg(int priority, const char *fmt, ...)
+	__attribute__((format(printf, 2, 3)));
+
+void log_stats(struct log_stats *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOG_H */
@@ -0,0 +1,144 @@
+/*
+ * Bounded queues between one producer and one consumer thread.
+ *
+ * The producer owns the tail counter. An element is copied in before the
+ * tail is published (release), so that the consumer never reads an element
+ * being written.
+ *
+ * The head counter is shared. When a QUEUE_DROP_OLDEST or QUEUE_LATEST queue
+ * is full, the producer drops the oldest element by moving the head forward
+ * with a compare-and-swap, and then overwrites it. Hence, the consumer copies
+ * an element out first, and then claims it by moving the head with a
+ * compare-and-swap as well: if the producer moved the head in between, the
+ * copy may be torn, and is discarded before retrying with the new head.
+ * Conversely, if the consumer claimed the oldest element first, the
+ * producer's compare-and-swap fails, and the new element takes the slot
+ * freed by the consumer.
+ *
+ * Each push is signaled on an eventfd, which may be shared by several
+ * queues of the same consumer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "queue.h"
+
+/**
+ * Initializes the queue pointed to by {@code q}, which holds up to
+ * {@code nel} elements of {@code elsz} bytes. A QUEUE_LATEST queue holds one
+ * element.
+ *
+ * Pushed elements are signaled on the eventfd {@code efd}.
+ */
+int
+queue_init(struct queue *q, size_t nel, size_t elsz, int efd,
+		enum queue_policy policy)
+{
+	if (policy == QUEUE_LATEST) {
+		nel = 1;
+	}
+	if (nel == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if ((q->buf = calloc(nel, elsz)) == NULL) {
+		return -1;
+	}
+
+	q->nel = nel;
+	q->elsz = elsz;
+	q->policy = policy;
+	q->efd = efd;
+	atomic_init(&q->head, 0);
+	atomic_init(&q->tail, 0);
+
+	return 0;
+}
+
+/**
+ * Releases the queue resources. The eventfd is not closed.
+ */
+void
+queue_destroy(struct queue *q)
+{
+	free(q->buf);
+	q->buf = NULL;
+}
+
+/**
+ * Pushes a copy of the element pointed to by {@code p}.
+ *
+ * When the queue is full, the outcome depends on the queue policy: the
+ * function returns 1 if the oldest element was dropped to make room for the
+ * new one, or -1 with errno set to EAGAIN if the new element was dropped.
+ * Otherwise, 0 is returned.
+ */
+int
+queue_push(struct queue *q, const void *p)
+{
+	int ret = 0;
+	uint64_t one = 1;
+	size_t head, tail;
+
+	tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+	if (tail - head == q->nel) {
+		if (q->policy == QUEUE_ALL) {
+			errno = EAGAIN;
+			return -1;
+		}
+
+		/* Drop oldest, unless the consumer just claimed it */
+		if (atomic_compare_exchange_strong_explicit(&q->head, &head, head + 1,
+				memory_order_acq_rel, memory_order_acquire)) {
+			ret = 1;
+		}
+	}
+
+	memcpy(q->buf + (tail % q->nel) * q->elsz, p, q->elsz);
+	atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+
+	/* Wake up consumer */
+	if (write(q->efd, &one, sizeof(one)) == -1 && errno != EAGAIN) {
+		return -1;
+	}
+
+	return ret;
+}
+
+/**
+ * Pops the oldest element, and copies it into {@code p}.
+ *
+ * If the queue is empty, -1 is returned and errno is set to EAGAIN.
+ */
+int
+queue_pop(struct queue *q, void *p)
+{
+	size_t head, tail;
+
+	head = atomic_load_explicit(&q->head, memory_order_acquire);
+
+	do {
+		tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+		if (head == tail) {
+			errno = EAGAIN;
+			return -1;
+		}
+
+		memcpy(p, q->buf + (head % q->nel) * q->elsz, q->elsz);
+	} while (!atomic_compare_exchange_weak_explicit(&q->head, &head, head + 1,
+			memory_order_acq_rel, memory_order_acquire));
+
+	return 0;
+}
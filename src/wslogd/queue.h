@@ -0,0 +1,56 @@
+#ifndef _QUEUE_H
+#define _QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Bounded queues between one producer and one consumer thread.
+ */
+
+/**
+ * What to do when the queue is full.
+ */
+enum queue_policy
+{
+	QUEUE_ALL,			/* Drop the new element */
+	QUEUE_DROP_OLDEST,		/* Drop the oldest element */
+	QUEUE_LATEST			/* Keep the latest element only */
+};
+
+/**
+ * Bounded queue of {@code nel} elements of {@code elsz} bytes.
+ *
+ * One thread pushes elements, another one pops them. The {@code head} and
+ * {@code tail} counters increase forever; the element index is the counter
+ * modulo {@code nel}. Only the producer moves {@code tail}, while both move
+ * {@code head}: the consumer when it pops an element, and the producer when
+ * it drops the oldest one (see queue.c).
+ */
+struct queue
+{
+	size_t nel;			/* Capacity */
+	size_t elsz;			/* Element size */
+	enum queue_policy policy;	/* Full queue policy */
+	atomic_size_t head;		/* Next element to pop */
+	atomic_size_t tail;		/* Next element to push */
+	int efd;			/* Wakeup event file descriptor */
+	char *buf;			/* Elements */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int queue_init(struct queue *q, size_t nel, size_t elsz, int efd,
+		enum queue_policy policy);
+void queue_destroy(struct queue *q);
+
+int queue_push(struct queue *q, const void *p);
+int queue_pop(struct queue *q, void *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _QUEUE_H */
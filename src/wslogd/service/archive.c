@@ -3,39 +3,75 @@
 #endif
 
 #include <pthread.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
 #include <errno.h>
 #include <time.h>
 #include <syslog.h>
+#include <sys/eventfd.h>
 
 #include "libws/util.h"
 
 #include "board.h"
 #include "conf.h"
+#include "log.h"
 #include "db/sqlite.h"
+#include "queue.h"
 #include "service/util.h"
 #include "service/archive.h"
 
 #define WSLOG_EPOCH 1514764800		/* Mon, 1 Jan 2018 00:00:00 */
 #define ARCHIVE_INTERVAL 600		/* Default archive interval */
-#define AR_LEN 64			/* Archive buffer size */
+#define AR_LEN 16			/* Archive records per fetch */
+#define BACKFILL_PAUSE 100		/* Pause between steps, in milliseconds */
+#define BACKFILL_RETRY 60		/* Retry delay on failure, in seconds */
+#define BACKFILL_TRIES 5		/* Consecutive failures before giving up */
+#define WRITER_QUEUE 64			/* Records waiting for the writer */
+#define WRITER_BATCH 16			/* Records per transaction */
 
 static enum ws_driver driver;		/* Driver */
 static int freq;			/* Archive frequency */
 static int hw_archive;			/* Hardware archive */
 static time_t current;			/* Last known console archive record */
 
+/*
+ * Missed console records are fetched in background, one step at a time,
+ * while the sensor service shares the device. Each step is committed on its
+ * own, hence an interrupted backfill resumes from the last saved record.
+ */
+static pthread_t backfill_tid;		/* Backfill thread */
+static int backfill_started;		/* Backfill thread started */
+static atomic_int backfill_stop;	/* Stop requested */
+static atomic_int backfill_running;	/* Backfill in progress */
+
+/*
+ * Records are saved by a writer thread, so that a slow disk does not delay
+ * the archive timer. The archive thread pushes records to a queue; the writer
+ * commits the pending records in a single transaction, once WRITER_BATCH
+ * records are pending or the commit delay elapsed.
+ *
+ * The database connection is shared by the writer, the backfill thread, and
+ * the archive thread when the queue is full: each transaction holds the
+ * database lock.
+ */
+static pthread_mutex_t db_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct queue writer_queue;	/* Pending records */
+static int writer_efd = -1;		/* Writer wakeup */
+static pthread_t writer_tid;		/* Writer thread */
+static int writer_started;		/* Writer thread started */
+static atomic_int writer_stop;		/* Stop requested */
+static atomic_ulong writer_lost;	/* Records not saved, not reported yet */
+
 static ssize_t
 push_record(struct ws_archive *ar, size_t nel)
 {
 	size_t i;
 
-	if (board_lock() == -1) {
-		syslog(LOG_ERR, "board_lock: %m");
-		goto error;
-	}
-
 	for (i = 0; i < nel; i++) {
 		int ret;
 
@@ -51,60 +87,319 @@ push_record(struct ws_archive *ar, size_t nel)
 		}
 	}
 
-	if (board_unlock() == -1) {
-		syslog(LOG_ERR, "board_unlock: %m");
+	return nel;
+}
+
+/**
+ * Saves {@code nel} records into database, in a single transaction.
+ */
+static int
+db_save(const struct ws_archive *ar, size_t nel)
+{
+	struct timespec start;
+
+	(void) pthread_mutex_lock(&db_lock);
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (sqlite_begin() == -1) {
+		goto error;
+	}
+	if (sqlite_insert(ar, nel) == -1) {
+		(void) sqlite_rollback();
+		goto error;
+	}
+	if (sqlite_commit() == -1) {
+		(void) sqlite_rollback();
 		goto error;
 	}
 
-	return nel;
+	board_stat_time(BOARD_HIST_SQLITE, &start);
+	(void) pthread_mutex_unlock(&db_lock);
+
+	return 0;
 
 error:
+	(void) pthread_mutex_unlock(&db_lock);
 	return -1;
 }
 
-static int
-bulk_fetch()
+/**
+ * Checkpoints the write-ahead log, once it holds enough pages. Run from
+ * background threads only.
+ */
+static void
+db_checkpoint(void)
+{
+	long pages = confp->archive.sqlite.checkpoint;
+	struct timespec start;
+
+	if (pages <= 0 || sqlite_wal_pages() < pages) {
+		return;
+	}
+
+	(void) pthread_mutex_lock(&db_lock);
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+
+	if (sqlite_checkpoint() == 0) {
+		board_stat_time(BOARD_HIST_CHECKPOINT, &start);
+	}
+
+	(void) pthread_mutex_unlock(&db_lock);
+}
+
+/**
+ * Pushes to the board the backfilled records newer than its last archive
+ * record. The archive timer is paused during the backfill, hence the backfill
+ * thread is the only writer of the board archive ring meanwhile.
+ */
+static void
+backfill_push(struct ws_archive *ar, size_t nel)
+{
+	size_t i;
+	struct ws_archive last;
+
+	/* Keep the ring in time order */
+	i = 0;
+	if (board_get_ar(0, &last) == 0) {
+		while (i < nel && ar[i].time <= last.time) {
+			i++;
+		}
+	}
+
+	(void) push_record(ar + i, nel - i);
+}
+
+/**
+ * Fetches the next missed console records, saves them into database, and
+ * updates the board.
+ *
+ * Returns the number of records, or -1 on failure.
+ */
+static ssize_t
+backfill_step(void)
 {
-	ssize_t sz, total;
+	ssize_t sz;
 	struct ws_archive arbuf[AR_LEN];
 
-	/* Start transaction */
-	if (sqlite_begin() == -1) {
+	sz = drv_get_ar(arbuf, AR_LEN, current);
+	if (sz == -1) {
 		return -1;
+	} else if (sz > 0) {
+		if (db_save(arbuf, sz) == -1) {
+			return -1;
+		}
+
+		backfill_push(arbuf, sz);
+
+		/* Next start point */
+		current = arbuf[sz - 1].time;
+
+		db_checkpoint();
 	}
 
+	return sz;
+}
+
+/**
+ * Sleeps for {@code ms} milliseconds, by steps of 100 ms, unless a stop is
+ * requested.
+ */
+static void
+backfill_pause(long ms)
+{
+	struct timespec ts;
+
+	ts.tv_sec = 0;
+	ts.tv_nsec = 100 * 1000000;
+
+	for (; 0 < ms && !atomic_load(&backfill_stop); ms -= 100) {
+		(void) nanosleep(&ts, NULL);
+	}
+}
+
+static void *
+backfill_main(void *arg)
+{
+	ssize_t sz;
+	unsigned long total;
+	time_t from;
+	int nfail;
+
+	(void) arg;
+
+	from = current;
 	total = 0;
+	nfail = 0;
 
-	/* Fetch records, and save them into database */
-	do {
-		sz = drv_get_ar(arbuf, AR_LEN, current);
-		if (sz == -1) {
-			goto error;
-		} else if (sz > 0) {
-			if (sqlite_insert(arbuf, sz) == -1) {
-				goto error;
+	board_stat_backfill(BOARD_BACKFILL_RUNNING, from, current, total);
+
+	while (!atomic_load(&backfill_stop)) {
+		if ((sz = backfill_step()) == -1) {
+			board_stat_backfill(BOARD_BACKFILL_FAILED, from, current, total);
+
+			/*
+			 * Persistent failure: let the archive timer resume. It catches
+			 * up with the remaining records, AR_LEN per period.
+			 */
+			if (++nfail == BACKFILL_TRIES) {
+				char ftime[20];
+
+				localftime_r(ftime, sizeof(ftime), &current, "%F %T");
+				log_msg(LOG_ERR, "Archive backfill failed %d times, "
+						"records after %s left to the archive timer",
+						BACKFILL_TRIES, ftime);
+				break;
 			}
 
-			total += sz;
+			log_msg(LOG_ERR, "Archive backfill failed, retrying in %ds", BACKFILL_RETRY);
+			backfill_pause(BACKFILL_RETRY * 1000);
+			continue;
+		}
 
-			/* Next start point */
-			current = arbuf[sz - 1].time;
+		nfail = 0;
+
+		total += sz;
+		board_stat_backfill(BOARD_BACKFILL_RUNNING, from, current, total);
+
+		if (sz < AR_LEN) {
+			log_msg(LOG_NOTICE, "Fetched %lu missed records", total);
+			board_stat_backfill(BOARD_BACKFILL_DONE, from, current, total);
+			break;
 		}
-	} while (sz == AR_LEN);
 
-	/* Commit */
-	if (sqlite_commit() == -1) {
-		goto error;
+		/* Let the sensor service use the device */
+		backfill_pause(BACKFILL_PAUSE);
 	}
 
-	syslog(LOG_NOTICE, "Fetched %zd missed records", total);
+	atomic_store(&backfill_running, 0);
 
-	return 0;
+	return NULL;
+}
 
-error:
-	(void) sqlite_rollback();
+static long
+elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
 
-	return -1;
+	(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000
+			+ (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+/**
+ * Saves a batch of records. When the batch transaction fails, records are
+ * saved one by one, so that a bad record does not take the others with it.
+ */
+static void
+writer_flush(const struct ws_archive *ar, size_t nel)
+{
+	size_t i, lost;
+
+	lost = 0;
+
+	if (db_save(ar, nel) == -1) {
+		for (i = 0; i < nel; i++) {
+			if (nel == 1 || db_save(&ar[i], 1) == -1) {
+				lost++;
+			}
+		}
+	}
+
+	board_stat_writer(nel - lost, lost);
+
+	if (lost > 0) {
+		log_msg(LOG_ERR, "%zu archive records not saved", lost);
+		atomic_fetch_add(&writer_lost, lost);
+	}
+
+	db_checkpoint();
+}
+
+static void *
+writer_main(void *arg)
+{
+	size_t n;
+	long delay;
+	struct timespec first;
+	struct ws_archive batch[WRITER_BATCH];
+
+	(void) arg;
+
+	delay = confp->archive.sqlite.commit_delay * 1000;
+	n = 0;
+
+	for (;;) {
+		int stop = atomic_load(&writer_stop);
+		int timeout;
+		uint64_t u;
+		struct pollfd pfd;
+
+		/* Pending records */
+		while (n < WRITER_BATCH && queue_pop(&writer_queue, &batch[n]) == 0) {
+			if (n++ == 0) {
+				(void) clock_gettime(CLOCK_MONOTONIC, &first);
+			}
+		}
+
+		if (n > 0) {
+			timeout = delay - elapsed_ms(&first);
+
+			if (stop || n == WRITER_BATCH || timeout <= 0) {
+				writer_flush(batch, n);
+				n = 0;
+				continue;
+			}
+		} else if (stop) {
+			break;
+		} else {
+			timeout = -1;
+		}
+
+		/* Wait for records */
+		pfd.fd = writer_efd;
+		pfd.events = POLLIN;
+
+		if (poll(&pfd, 1, timeout) > 0) {
+			(void) read(writer_efd, &u, sizeof(u));
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Starts a helper thread of the archive service, with all signals blocked
+ * and the archive thread stack size.
+ */
+static int
+archive_thread(pthread_t *tid, void *(*func)(void *))
+{
+	int ret;
+	sigset_t set, oset;
+	pthread_attr_t attr;
+
+	/* Signals are handled by the main thread */
+	(void) sigfillset(&set);
+	(void) pthread_sigmask(SIG_SETMASK, &set, &oset);
+
+	(void) pthread_attr_init(&attr);
+	if (confp->archive.sched.stack) {
+		(void) pthread_attr_setstacksize(&attr, confp->archive.sched.stack);
+	}
+
+	ret = pthread_create(tid, &attr, func, NULL);
+
+	(void) pthread_attr_destroy(&attr);
+	(void) pthread_sigmask(SIG_SETMASK, &oset, NULL);
+
+	if (ret != 0) {
+		errno = ret;
+		log_msg(LOG_ERR, "pthread_create: %m");
+		return -1;
+	}
+
+	return 0;
 }
 
 int
@@ -130,7 +425,7 @@ archive_init(struct itimerspec *it)
 	if (confp->archive.freq == 0) {
 		/* Set above */
 	} else if (hw_archive && confp->archive.freq != it->it_interval.tv_sec) {
-		syslog(LOG_ERR, "Hardware archive differs from archive.freq");
+		log_msg(LOG_ERR, "Hardware archive differs from archive.freq");
 		goto error;
 	}
 
@@ -182,83 +477,196 @@ archive_init(struct itimerspec *it)
 				current = arbuf.time;
 
 				localftime_r(ftime, sizeof(ftime), &current, "%F %T");
-				syslog(LOG_NOTICE, "Last db record: %s", ftime);
+				log_msg(LOG_NOTICE, "Last db record: %s", ftime);
 			} else {
 				current = WSLOG_EPOCH;
 			}
 
-			/* Load console records after that point */
-			if (bulk_fetch() == -1) {
-				goto error;
-			}
-
-			/* Adjust timer delay */
-			if (drv_get_ar_itimer(it) == -1) {
-				goto error;
-			}
+			/* Load console records after that point, in background */
+			atomic_store(&backfill_running, 1);
 		}
 	} else {
 		/* Start from now on */
 		time(&current);
 	}
 
+	/* Fetch records once the console wrote them */
+	if (hw_archive) {
+		it->it_value.tv_sec = confp->archive.delay;
+	}
+
 #ifdef DEBUG
-	syslog(LOG_INFO, "archive.freq=%ld\n", it->it_interval.tv_sec);
-	syslog(LOG_INFO, "archive.delay=%ld\n", it->it_value.tv_sec);
-	syslog(LOG_INFO, "archive.hardware=%d\n", hw_archive);
+	log_msg(LOG_INFO, "archive.freq=%ld\n", it->it_interval.tv_sec);
+	log_msg(LOG_INFO, "archive.delay=%ld\n", it->it_value.tv_sec);
+	log_msg(LOG_INFO, "archive.hardware=%d\n", hw_archive);
 #endif
 
-	syslog(LOG_INFO, "Archive service ready");
+	log_msg(LOG_INFO, "Archive service ready");
+
+	return 0;
+
+error:
+	return -1;
+}
+
+/**
+ * Starts the database writer, and the archive backfill if records were
+ * missed. The shared board shall be open.
+ */
+int
+archive_start(void)
+{
+	atomic_store(&backfill_stop, 0);
+	atomic_store(&writer_stop, 0);
+
+	/* Database writer */
+	if (confp->archive.sqlite.enabled) {
+		writer_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		if (writer_efd == -1) {
+			log_msg(LOG_ERR, "eventfd: %m");
+			goto error;
+		}
+
+		if (queue_init(&writer_queue, WRITER_QUEUE, sizeof(struct ws_archive),
+				writer_efd, QUEUE_ALL) == -1) {
+			log_msg(LOG_ERR, "queue_init: %m");
+			goto error;
+		}
+
+		if (archive_thread(&writer_tid, writer_main) == -1) {
+			queue_destroy(&writer_queue);
+			goto error;
+		}
+
+		writer_started = 1;
+	}
+
+	/* Backfill */
+	if (atomic_load(&backfill_running)) {
+		if (archive_thread(&backfill_tid, backfill_main) == -1) {
+			atomic_store(&backfill_running, 0);
+			return -1;
+		}
+
+		backfill_started = 1;
+	}
 
 	return 0;
 
 error:
+	if (writer_efd != -1) {
+		(void) close(writer_efd);
+		writer_efd = -1;
+	}
 	return -1;
 }
 
+/**
+ * Hands {@code nel} records over to the writer. When the writer lags behind
+ * and its queue is full, records are saved inline.
+ */
+static int
+archive_save(const struct ws_archive *ar, size_t nel)
+{
+	size_t i;
+
+	for (i = 0; i < nel; i++) {
+		if (queue_push(&writer_queue, &ar[i]) == -1) {
+			if (errno != EAGAIN) {
+				log_msg(LOG_ERR, "queue_push: %m");
+			} else if (db_save(&ar[i], 1) == -1) {
+				board_stat_writer(0, 1);
+				return -1;
+			} else {
+				board_stat_writer(1, 0);
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Returns the number of records the writer failed to save since the last
+ * call.
+ */
+unsigned long
+archive_lost(void)
+{
+	return atomic_exchange(&writer_lost, 0);
+}
+
+/**
+ * Fetches the archive records since the last known one, saves them into
+ * database and updates the board. Up to AR_LEN records are fetched per
+ * period, so that records left over by a failed backfill are caught up.
+ *
+ * Returns 1 if a record was fetched into {@code ar}, the most recent one, 0
+ * if none, or -1 on failure. No record is fetched while missed records are
+ * backfilled.
+ */
 int
 archive_sig_timer(struct ws_archive *ar)
 {
 	ssize_t sz;
+	struct timespec start;
+	struct ws_archive arbuf[AR_LEN];
 
 	/* Device archive */
 	if (hw_archive) {
-		if ((sz = drv_get_ar(ar, 1, current)) == -1) {
+		if (atomic_load(&backfill_running)) {
+			log_msg(LOG_INFO, "Archive backfill in progress");
+			return 0;
+		}
+
+		(void) clock_gettime(CLOCK_MONOTONIC, &start);
+
+		if ((sz = drv_get_ar(arbuf, AR_LEN, current)) == -1) {
 			goto error;
 		}
 
+		board_stat_time(BOARD_HIST_DRV_AR, &start);
+
 		if (sz > 0) {
-			current = ar->time;
+			current = arbuf[sz - 1].time;
+		}
+		if (sz > 1) {
+			log_msg(LOG_NOTICE, "Fetched %zd archive records", sz);
 		}
 	} else {
-		ar->wl_mask = 0;
+		arbuf[0].wl_mask = 0;
 		sz = 1;
 	}
 
 	/* Update board */
-	sz = push_record(ar, sz);
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+	sz = push_record(arbuf, sz);
+	board_stat_time(BOARD_HIST_PUSH_AR, &start);
+
 	if (sz == -1) {
 		goto error;
 	} else if (sz > 0) {
+		*ar = arbuf[sz - 1];
+
 #ifdef DEBUG
 		char ftime[20];
 
 		localftime_r(ftime, sizeof(ftime), &ar->time, "%F %T");
-		syslog(LOG_DEBUG, "Record: %s %.1f°C %hhu%% %.1fhPa",
+		log_msg(LOG_DEBUG, "Record: %s %.1f°C %hhu%% %.1fhPa",
 				ftime, ar->temp, ar->humidity, ar->barometer);
 #endif
 
 		/* Save to database */
 		if (confp->archive.sqlite.enabled) {
-			if (sqlite_insert(ar, sz) == -1) {
+			if (archive_save(arbuf, sz) == -1) {
 				goto error;
 			}
 		}
 	} else {
-		syslog(LOG_NOTICE, "No archive fetched");
+		log_msg(LOG_NOTICE, "No archive fetched");
 	}
 
-	return 0;
+	return sz > 0;
 
 error:
 	return -1;
@@ -267,6 +675,28 @@ error:
 int
 archive_destroy(void)
 {
+	/* Interrupt backfill; it resumes on next start */
+	if (backfill_started) {
+		atomic_store(&backfill_stop, 1);
+		(void) pthread_join(backfill_tid, NULL);
+
+		backfill_started = 0;
+	}
+
+	atomic_store(&backfill_running, 0);
+
+	/* Flush pending records */
+	if (writer_started) {
+		atomic_store(&writer_stop, 1);
+		(void) eventfd_write(writer_efd, 1);
+		(void) pthread_join(writer_tid, NULL);
+
+		queue_destroy(&writer_queue);
+		(void) close(writer_efd);
+		writer_efd = -1;
+		writer_started = 0;
+	}
+
 	if (confp->archive.sqlite.enabled) {
 		if (sqlite_destroy() == -1) {
 			return -1;
@@ -10,9 +10,11 @@ extern "C" {
 #endif
 
 int archive_init(struct itimerspec *it);
+int archive_start(void);
 int archive_destroy(void);
 
 int archive_sig_timer(struct ws_archive *ar);
+unsigned long archive_lost(void);
 
 #ifdef __cplusplus
 }
@@ -16,6 +16,7 @@
 #include "libws/aggregate.h"
 
 #include "conf.h"
+#include "log.h"
 #include "curl.h"
 #include "board.h"
 #include "wslogd.h"
@@ -151,6 +152,20 @@ ic_put(const struct ic *p)
 			goto error;
 		}
 
+		code = curl_easy_timeout(curl);
+		if (code != CURLE_OK) {
+			curl_log("curl_easy_timeout", code);
+			goto error;
+		}
+
+		if (confp->worker.profile == PROFILE_SMALL) {
+			code = curl_easy_small(curl);
+			if (code != CURLE_OK) {
+				curl_log("curl_easy_small", code);
+				goto error;
+			}
+		}
+
 		code = curl_easy_upload(curl, url, datfd);
 		if (code != CURLE_OK) {
 			curl_log("curl_easy_upload", code);
@@ -170,7 +185,7 @@ ic_put(const struct ic *p)
 		curl_easy_cleanup(curl);
 		curl = NULL;
 	} else {
-		syslog(LOG_ERR, "curl_easy_init: failure\n");
+		log_msg(LOG_ERR, "curl_easy_init: failure\n");
 		goto error;
 	}
 
@@ -185,13 +200,13 @@ error:
 }
 
 int
-ic_init(int *flags, struct itimerspec *it)
+ic_init(struct service_opts *opts)
 {
 	char template[20] = "/tmp/wslogXXXXXX";
 
 	/* Check parameters */
 	if (!confp->stat_ic.station || !confp->stat_ic.username || !confp->stat_ic.password) {
-		syslog(LOG_ERR, "StatIC: station, username or password not set");
+		log_msg(LOG_ERR, "StatIC: station, username or password not set");
 		goto error;
 	}
 
@@ -202,13 +217,16 @@ ic_init(int *flags, struct itimerspec *it)
 	}
 
 	if ((datfd = mkstemp(template)) == -1) {
-		syslog(LOG_ERR, "mkstemp: %m");
+		log_msg(LOG_ERR, "mkstemp: %m");
 		goto error;
 	}
 
-	itimer_setdelay(it, freq, 0);
+	itimer_setdelay(&opts->itimer, freq, 0);
 
-	*flags = SRV_EVENT_RT | SRV_EVENT_AR;
+	opts->flags = SRV_EVENT_RT | SRV_EVENT_AR;
+	opts->delivery = confp->stat_ic.delivery;
+	opts->sched = confp->stat_ic.sched;
+	opts->queue = confp->stat_ic.queue;
 
 	/* Internal data */
 	datidx = 0;
@@ -317,7 +335,7 @@ ic_sig_ar(const struct ws_archive *ar)
 
 	/* Process archive element */
 	if (ic_put(curr) == -1) {
-		syslog(LOG_ERR, "StatIC service error");
+		log_msg(LOG_ERR, "StatIC service error");
 
 		/* Continue, not a fatal error */
 	}
@@ -330,3 +348,12 @@ ic_sig_ar(const struct ws_archive *ar)
 
 	return 0;
 }
+
+const struct service ic_service = {
+	.abi = SERVICE_ABI,
+	.name = "stat_ic",
+	.init = ic_init,
+	.on_loop = ic_sig_rt,
+	.on_archive = ic_sig_ar,
+	.destroy = ic_destroy
+};
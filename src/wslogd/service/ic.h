@@ -4,17 +4,20 @@
 #include <time.h>
 
 #include "dataset.h"
+#include "service/service.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int ic_init(int *flags, struct itimerspec *it);
+int ic_init(struct service_opts *opts);
 int ic_destroy(void);
 
 int ic_sig_rt(const struct ws_loop *rt);
 int ic_sig_ar(const struct ws_archive *ar);
 
+extern const struct service ic_service;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,235 @@
+/*
+ * Service registry.
+ *
+ * Services are run in registration order, after the sensor and archive
+ * services. Built-in services are registered when enabled in the
+ * configuration, followed by the services loaded from shared objects.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <syslog.h>
+
+#include "conf.h"
+#include "log.h"
+#include "service/ic.h"
+#include "service/sync.h"
+#include "service/wunder.h"
+#include "service/registry.h"
+
+struct registry_entry
+{
+	const struct service *srv;		/* Service */
+	void *handle;				/* Shared object, if any */
+	int section;				/* Configuration section, or -1 */
+};
+
+static struct registry_entry *entries;
+static size_t nentries;
+
+static int
+registry_append(const struct service *srv, void *handle, int section)
+{
+	struct registry_entry *p;
+
+	if ((p = realloc(entries, (nentries + 1) * sizeof(*p))) == NULL) {
+		log_msg(LOG_ERR, "realloc: %m");
+		return -1;
+	}
+
+	entries = p;
+	entries[nentries].srv = srv;
+	entries[nentries].handle = handle;
+	entries[nentries].section = section;
+	nentries++;
+
+	return 0;
+}
+
+/**
+ * Registers the service pointed to by {@code srv}.
+ *
+ * The service has no configuration section: it is restarted on each
+ * configuration reload.
+ */
+int
+registry_add(const struct service *srv)
+{
+	return registry_append(srv, NULL, -1);
+}
+
+/**
+ * Loads and registers the service exported by the shared object
+ * {@code path}.
+ */
+int
+registry_load(const char *path)
+{
+	void *handle;
+	const struct service *srv;
+
+	if ((handle = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+		log_msg(LOG_ERR, "dlopen: %s", dlerror());
+		errno = ENOENT;
+		return -1;
+	}
+
+	if ((srv = dlsym(handle, SERVICE_SYM)) == NULL) {
+		log_msg(LOG_ERR, "dlsym %s: %s", path, dlerror());
+		errno = EINVAL;
+		goto error;
+	}
+	if (srv->abi != SERVICE_ABI) {
+		log_msg(LOG_ERR, "%s: unsupported service interface %d", path, srv->abi);
+		errno = EINVAL;
+		goto error;
+	}
+	if (srv->name == NULL || srv->init == NULL) {
+		log_msg(LOG_ERR, "%s: invalid service", path);
+		errno = EINVAL;
+		goto error;
+	}
+
+	if (registry_append(srv, handle, -1) == -1) {
+		goto error;
+	}
+
+	log_msg(LOG_INFO, "Service %s loaded from %s", srv->name, path);
+
+	return 0;
+
+error:
+	(void) dlclose(handle);
+	return -1;
+}
+
+static int
+registry_modules(const char *modules)
+{
+	char *buf, *tok, *saveptr;
+
+	if ((buf = strdup(modules)) == NULL) {
+		return -1;
+	}
+
+	for (tok = strtok_r(buf, " \t", &saveptr); tok != NULL;
+			tok = strtok_r(NULL, " \t", &saveptr)) {
+		if (registry_load(tok) == -1) {
+			goto error;
+		}
+	}
+
+	free(buf);
+
+	return 0;
+
+error:
+	free(buf);
+	return -1;
+}
+
+/**
+ * Registers the services enabled in the configuration.
+ */
+int
+registry_init(void)
+{
+	registry_clear();
+
+	/* Built-in services */
+	if (confp->sync.enabled) {
+		if (registry_append(&sync_service, NULL, CONF_SYNC) == -1) {
+			return -1;
+		}
+	} else {
+		log_msg(LOG_WARNING, "Console time synchronization disabled");
+	}
+	if (confp->stat_ic.enabled) {
+		if (registry_append(&ic_service, NULL, CONF_STAT_IC) == -1) {
+			return -1;
+		}
+	}
+	if (confp->wunder.enabled) {
+		if (registry_append(&wunder_service, NULL, CONF_WUNDER) == -1) {
+			return -1;
+		}
+	}
+
+	/* Shared objects */
+	if (confp->worker.modules) {
+		if (registry_modules(confp->worker.modules) == -1) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Unregisters all services, and unloads shared objects.
+ */
+void
+registry_clear(void)
+{
+	size_t i;
+
+	for (i = 0; i < nentries; i++) {
+		if (entries[i].handle) {
+			(void) dlclose(entries[i].handle);
+		}
+	}
+
+	free(entries);
+	entries = NULL;
+	nentries = 0;
+}
+
+/**
+ * Returns the number of registered services.
+ */
+size_t
+registry_count(void)
+{
+	return nentries;
+}
+
+/**
+ * Returns the registered service {@code i}.
+ */
+const struct service *
+registry_get(size_t i)
+{
+	return entries[i].srv;
+}
+
+/**
+ * Tells whether the registered service {@code i} shall be restarted to run
+ * with the configuration {@code cfg}.
+ */
+int
+registry_changed(size_t i, const struct ws_conf *cfg)
+{
+	if (entries[i].section == -1) {
+		return 1;
+	}
+
+	return conf_changed(cfg, entries[i].section);
+}
+
+/**
+ * Applies the configuration section of the registered service {@code i},
+ * from {@code cfg}. The service shall be stopped.
+ */
+void
+registry_apply(size_t i, struct ws_conf *cfg)
+{
+	if (entries[i].section != -1) {
+		conf_apply(cfg, entries[i].section);
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef _SERVICE_REGISTRY_H
+#define _SERVICE_REGISTRY_H
+
+/**
+ * Service registry.
+ */
+
+#include <sys/types.h>
+
+#include "conf.h"
+#include "service/service.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int registry_add(const struct service *srv);
+int registry_load(const char *path);
+int registry_init(void);
+void registry_clear(void);
+
+size_t registry_count(void);
+const struct service *registry_get(size_t i);
+
+int registry_changed(size_t i, const struct ws_conf *cfg);
+void registry_apply(size_t i, struct ws_conf *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SERVICE_REGISTRY_H */
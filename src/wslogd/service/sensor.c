@@ -5,7 +5,9 @@
 #include <time.h>
 #include <syslog.h>
 
+#include "board.h"
 #include "conf.h"
+#include "log.h"
 #include "driver/driver.h"
 #include "service/util.h"
 #include "service/sensor.h"
@@ -29,12 +31,12 @@ sensor_init(struct itimerspec *it)
 	}
 
 #ifdef DEBUG
-	syslog(LOG_INFO, "driver.freq=%ld.%ld\n", it->it_interval.tv_sec,
+	log_msg(LOG_INFO, "driver.freq=%ld.%ld\n", it->it_interval.tv_sec,
 			it->it_interval.tv_nsec / 1000000);
-	syslog(LOG_INFO, "driver.delay=%ld\n", it->it_value.tv_sec);
+	log_msg(LOG_INFO, "driver.delay=%ld\n", it->it_value.tv_sec);
 #endif
 
-	syslog(LOG_INFO, "Sensor service ready");
+	log_msg(LOG_INFO, "Sensor service ready");
 
 	return 0;
 
@@ -45,22 +47,35 @@ error:
 int
 sensor_sig_timer(struct ws_loop *rt)
 {
+	struct timespec start;
+
 	rt->time.tv_sec = 0;
 
 	/* Read sensors */
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+
 	if (drv_get_rt(rt) == -1) {
+		/* No sample, drop the ones out of the windows */
+		board_window_expire(time(NULL));
 		goto error;
 	}
 
+	board_stat_time(BOARD_HIST_DRV_RT, &start);
+
 	if (rt->time.tv_sec == 0) {
 		if (clock_gettime(CLOCK_REALTIME, &rt->time) == -1) {
-			syslog(LOG_ERR, "clock_gettime(): %m");
+			log_msg(LOG_ERR, "clock_gettime(): %m");
 			goto error;
 		}
 	}
 
+	/* Update board */
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+	board_push(rt);
+	board_stat_time(BOARD_HIST_PUSH_RT, &start);
+
 #if DEBUG
-	syslog(LOG_DEBUG, "Sensor: %.1f°C %hhu%% %.1fhPa",
+	log_msg(LOG_DEBUG, "Sensor: %.1f°C %hhu%% %.1fhPa",
 			rt->temp, rt->humidity, rt->barometer);
 #endif
 
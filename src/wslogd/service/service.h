@@ -0,0 +1,56 @@
+#ifndef _SERVICE_SERVICE_H
+#define _SERVICE_SERVICE_H
+
+/**
+ * Service interface.
+ *
+ * A service is described by a {@code struct service}. Built-in services are
+ * linked into the daemon; others are loaded from shared objects, which
+ * export the description as the {@code wslog_service} symbol:
+ *
+ *	const struct service wslog_service = {
+ *		.abi = SERVICE_ABI,
+ *		.name = "example",
+ *		...
+ *	};
+ *
+ * The {@code init} function sets the events the service subscribes to
+ * (SRV_TIMER, SRV_EVENT_RT and SRV_EVENT_AR flags) and the timer interval,
+ * and may change the event delivery policy and the thread options. With
+ * SRV_TIMER_WALL, the timer is aligned on the wall clock (see
+ * itimer_setdelay()). Event functions return 0 on success, or -1 on
+ * failure. Unused functions may be NULL, except {@code init}.
+ */
+
+#include <time.h>
+
+#include "conf.h"
+#include "dataset.h"
+#include "queue.h"
+#include "service/util.h"
+
+#define SERVICE_ABI 1			/* Service interface version */
+#define SERVICE_SYM "wslog_service"	/* Shared object symbol */
+
+struct service_opts
+{
+	int flags;				/* Subscribed events */
+	struct itimerspec itimer;		/* Timer interval */
+	enum queue_policy delivery;		/* Event delivery policy */
+	size_t queue;				/* Event queue length */
+	struct ws_sched sched;			/* Thread options */
+};
+
+struct service
+{
+	int abi;				/* SERVICE_ABI */
+	const char *name;			/* Service name */
+
+	int (*init)(struct service_opts *opts);
+	int (*on_timer)(void);
+	int (*on_loop)(const struct ws_loop *rt);
+	int (*on_archive)(const struct ws_archive *ar);
+	int (*destroy)(void);
+};
+
+#endif /* _SERVICE_SERVICE_H */
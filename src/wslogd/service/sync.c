@@ -6,6 +6,7 @@
 #include <syslog.h>
 
 #include "conf.h"
+#include "log.h"
 #include "service/util.h"
 #include "service/sync.h"
 
@@ -14,7 +15,7 @@ static long max_drift;		/* Max drift, in seconds */
 static long panic_drift;	/* Do not synchronize beyond this limit */
 
 int
-sync_init(int *flags, struct itimerspec *it)
+sync_init(struct service_opts *opts)
 {
 	freq = confp->sync.freq;
 	max_drift = confp->sync.max_drift;
@@ -31,15 +32,16 @@ sync_init(int *flags, struct itimerspec *it)
 	 * Delay first synchronization, to make sure that the system clock
 	 * is correctly set upon startup when there is no RTC backup battery.
 	 */
-	itimer_setdelay(it, freq, 300);
+	itimer_setdelay(&opts->itimer, freq, 300);
 
 #ifdef DEBUG
-	syslog(LOG_INFO, "sync.freq=%ld\n", it->it_interval.tv_sec);
+	log_msg(LOG_INFO, "sync.freq=%ld\n", opts->itimer.it_interval.tv_sec);
 #endif
 
-	*flags = SRV_TIMER;
+	opts->flags = SRV_TIMER | SRV_TIMER_WALL;
+	opts->sched = confp->sync.sched;
 
-	syslog(LOG_INFO, "Time synchronization service ready");
+	log_msg(LOG_INFO, "Time synchronization service ready");
 
 	return 0;
 
@@ -62,13 +64,13 @@ sync_sig_timer(void)
 
 	/* Beyond limit, adjust time */
 	if (labs(diff) > panic_drift) {
-		syslog(LOG_CRIT, "Time beyond limit (%lds)", diff);
+		log_msg(LOG_CRIT, "Time beyond limit (%lds)", diff);
 	} else if (labs(diff) > confp->sync.max_drift) {
 		if (drv_settime(now) == -1) {
 			goto error;
 		}
 
-		syslog(LOG_INFO, "Console time adjusted (%lds)", diff);
+		log_msg(LOG_INFO, "Console time adjusted (%lds)", diff);
 	}
 
 	return 0;
@@ -82,3 +84,11 @@ sync_destroy(void)
 {
 	return 0;
 }
+
+const struct service sync_service = {
+	.abi = SERVICE_ABI,
+	.name = "sync",
+	.init = sync_init,
+	.on_timer = sync_sig_timer,
+	.destroy = sync_destroy
+};
@@ -7,15 +7,19 @@
 
 #include <time.h>
 
+#include "service/service.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int sync_init(int *flags, struct itimerspec *it);
+int sync_init(struct service_opts *opts);
 int sync_destroy(void);
 
 int sync_sig_timer(void);
 
+extern const struct service sync_service;
+
 #ifdef __cplusplus
 }
 #endif
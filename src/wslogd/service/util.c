@@ -13,16 +13,17 @@ itimer_set(struct itimerspec *it, long sec)
 	it->it_value.tv_nsec = 0;
 }
 
+/**
+ * Sets a wall clock timer (SRV_TIMER_WALL), expiring every {@code freq}
+ * seconds, {@code delay} seconds after each multiple of {@code freq} since
+ * the Epoch.
+ */
 void
 itimer_setdelay(struct itimerspec *it, long freq, long delay)
 {
-	time_t now;
-
-	time(&now);
-
 	it->it_interval.tv_sec = freq;
 	it->it_interval.tv_nsec = 0;
-	it->it_value.tv_sec = (freq - now % freq) + delay;
+	it->it_value.tv_sec = delay;
 	it->it_value.tv_nsec = 0;
 }
 
@@ -6,6 +6,7 @@
 #define SRV_TIMER	1
 #define SRV_EVENT_RT	2
 #define SRV_EVENT_AR	4
+#define SRV_TIMER_WALL	8		/* Timer aligned on the wall clock */
 
 #ifdef __cplusplus
 extern "C" {
@@ -14,6 +14,7 @@
 #include "libws/util.h"
 
 #include "conf.h"
+#include "log.h"
 #include "curl.h"
 #include "board.h"
 #include "wslogd.h"
@@ -84,7 +85,7 @@ http_write(char *ptr, size_t size, size_t nmemb, struct ws_http *s)
 		s->buf = realloc(s->buf, s->len);
 
 		if (s->buf == NULL) {
-			syslog(LOG_ERR, "realloc: %m");
+			log_msg(LOG_ERR, "realloc: %m");
 			return 0;
 		}
 	}
@@ -117,10 +118,10 @@ wunder_url(char *str, size_t len, CURL *h, const struct ws_loop *p)
 			"PASSWORD", password,
 			"dateutc", dateutc, (p->time.tv_nsec / 1000000));
 	if (ret == -1) {
-		syslog(LOG_ERR, "snprintf: %m");
+		log_msg(LOG_ERR, "snprintf: %m");
 		goto error;
 	} else if (len <= (size_t) ret) {
-		syslog(LOG_ERR, "snprintf: Buffer overflow (%d bytes required)", ret);
+		log_msg(LOG_ERR, "snprintf: Buffer overflow (%d bytes required)", ret);
 		goto error;
 	}
 
@@ -143,10 +144,10 @@ wunder_url(char *str, size_t len, CURL *h, const struct ws_loop *p)
 			/* Add parameter */
 			ret = snprintf(str, len, "&%s=%f", params[i].param, value);
 			if (ret == -1) {
-				syslog(LOG_ERR, "snprintf: %m");
+				log_msg(LOG_ERR, "snprintf: %m");
 				goto error;
 			} else if (len <= (size_t) ret) {
-				syslog(LOG_ERR, "snprintf: Buffer overflow (%d bytes required)", ret);
+				log_msg(LOG_ERR, "snprintf: Buffer overflow (%d bytes required)", ret);
 				goto error;
 			}
 
@@ -183,10 +184,24 @@ wunder_perform(const struct ws_loop *p)
 		}
 
 #ifdef DEBUG
-		syslog(LOG_DEBUG, "Wunderground: %s", url);
+		log_msg(LOG_DEBUG, "Wunderground: %s", url);
 #endif
 
 		/* Set request option */
+		code = curl_easy_timeout(curl);
+		if (code != CURLE_OK) {
+			curl_log("curl_easy_timeout", code);
+			goto error;
+		}
+
+		if (confp->worker.profile == PROFILE_SMALL) {
+			code = curl_easy_small(curl);
+			if (code != CURLE_OK) {
+				curl_log("curl_easy_small", code);
+				goto error;
+			}
+		}
+
 		code = curl_easy_setopt(curl, CURLOPT_URL, url);
 		if (code != CURLE_OK) {
 			curl_log("curl_easy_setopt", code);
@@ -216,14 +231,14 @@ wunder_perform(const struct ws_loop *p)
 		curl_easy_cleanup(curl);
 		curl = NULL;
 	} else {
-		syslog(LOG_ERR, "curl_easy_init: failure\n");
+		log_msg(LOG_ERR, "curl_easy_init: failure\n");
 		goto error;
 	}
 
 	/* Check response */
 	ret = dry_run || (iobuf.buf && !strncmp("success\n", iobuf.buf, iobuf.len)) ? 0 : -1;
 	if (ret == -1) {
-		syslog(LOG_ERR, "Wunderground response: %*s", (int) iobuf.len, iobuf.buf);
+		log_msg(LOG_ERR, "Wunderground response: %*s", (int) iobuf.len, iobuf.buf);
 	}
 
 	http_cleanup(&iobuf);
@@ -240,12 +255,12 @@ error:
 }
 
 int
-wunder_init(int *flags, struct itimerspec *it)
+wunder_init(struct service_opts *opts)
 {
 	CURLcode code;
 
 	if (!confp->wunder.station || !confp->wunder.password) {
-		syslog(LOG_ERR, "Wunderground: station or password not set");
+		log_msg(LOG_ERR, "Wunderground: station or password not set");
 		goto error;
 	}
 
@@ -255,7 +270,10 @@ wunder_init(int *flags, struct itimerspec *it)
 		freq = 600;
 	}
 
-	itimer_setdelay(it, freq, 0);
+	itimer_setdelay(&opts->itimer, freq, 0);
+
+	opts->flags = SRV_TIMER | SRV_TIMER_WALL;
+	opts->sched = confp->wunder.sched;
 
 	return 0;
 
@@ -267,32 +285,22 @@ int
 wunder_sig_timer(void)
 {
 	struct ws_loop arbuf;
-	const struct ws_loop *p;
 
-	/* Peek last archive element */
-	if (board_lock() == -1) {
-		syslog(LOG_CRIT, "board_lock: %m");
-		goto error;
-	}
-
-	p = board_peek(0);
-
-	if (p != NULL) {
-		memcpy(&arbuf, p, sizeof(*p));
-	}
+	/* Peek last sensor element */
+	if (board_get(0, &arbuf) == -1) {
+		if (errno == ENODATA) {
+			return 0;
+		}
 
-	if (board_unlock() == -1) {
-		syslog(LOG_CRIT, "board_unlock: %m");
+		log_msg(LOG_CRIT, "board_get: %m");
 		goto error;
 	}
 
-	/* Process archive element */
-	if (p != NULL) {
-		if (wunder_perform(&arbuf) == -1) {
-			syslog(LOG_ERR, "Wunderground service error");
+	/* Process sensor element */
+	if (wunder_perform(&arbuf) == -1) {
+		log_msg(LOG_ERR, "Wunderground service error");
 
-			/* Continue, not a fatal error */
-		}
+		/* Continue, not a fatal error */
 	}
 
 	return 0;
@@ -306,3 +314,11 @@ wunder_destroy(void)
 {
 	return 0;
 }
+
+const struct service wunder_service = {
+	.abi = SERVICE_ABI,
+	.name = "wunder",
+	.init = wunder_init,
+	.on_timer = wunder_sig_timer,
+	.destroy = wunder_destroy
+};
@@ -7,15 +7,19 @@
 
 #include <time.h>
 
+#include "service/service.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int wunder_init(int *flags, struct itimerspec *it);
+int wunder_init(struct service_opts *opts);
 int wunder_destroy(void);
 
 int wunder_sig_timer(void);
 
+extern const struct service wunder_service;
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,351 @@
+/*
+ * Rolling windows.
+ *
+ * Windows are updated on each sample, in constant time. Sliding windows are
+ * split into WIN_BUCKETS buckets: samples are added to the current bucket and
+ * to the window statistics, and the buckets that expire when the current
+ * bucket changes are subtracted from the window statistics. Hence, a window
+ * covers between WIN_BUCKETS - 1 and WIN_BUCKETS buckets.
+ *
+ * Calendar day windows are reset at local midnight.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+
+#include "libws/defs.h"
+
+#include "window.h"
+
+struct win_bucket
+{
+	time_t start;			/* Bucket start */
+	struct win_wind wind;		/* Wind vector */
+	struct win_stat stat[];		/* Field statistics */
+};
+
+static size_t
+win_bucket_size(size_t nfields)
+{
+	return sizeof(struct win_bucket) + nfields * sizeof(struct win_stat);
+}
+
+static struct win_bucket *
+win_bucket_at(struct window *w, size_t i)
+{
+	char *p = (char *) &w->stat[w->nfields];
+
+	return (struct win_bucket *) (p + i * win_bucket_size(w->nfields));
+}
+
+/**
+ * Computes the size of a window of length {@code len}, holding
+ * {@code nfields} fields.
+ */
+size_t
+window_size(long len, size_t nfields)
+{
+	size_t sz;
+
+	sz = sizeof(struct window) + nfields * sizeof(struct win_stat);
+
+	if (len != WIN_DAY) {
+		sz += WIN_BUCKETS * win_bucket_size(nfields);
+	}
+
+	return sz;
+}
+
+static void
+win_stat_add(struct win_stat *p, time_t t, double v)
+{
+	if (p->count == 0 || v < p->min) {
+		p->min = v;
+		p->min_time = t;
+	}
+	if (p->count == 0 || p->max < v) {
+		p->max = v;
+		p->max_time = t;
+	}
+
+	p->sum += v;
+	p->count++;
+}
+
+/**
+ * Removes the values of {@code q} from {@code p}, but the lowest and highest
+ * ones. Returns 1 if {@code q} may hold the lowest or highest value of
+ * {@code p}, which shall then be recomputed.
+ */
+static int
+win_stat_sub(struct win_stat *p, const struct win_stat *q)
+{
+	if (q->count == 0) {
+		return 0;
+	}
+
+	p->count -= q->count;
+	p->sum -= q->sum;
+
+	/* No rounding left over */
+	if (p->count == 0) {
+		memset(p, 0, sizeof(*p));
+		return 0;
+	}
+
+	return q->min <= p->min || p->max <= q->max;
+}
+
+static void
+win_wind_merge(struct win_wind *p, const struct win_wind *q)
+{
+	p->count += q->count;
+	p->u += q->u;
+	p->v += q->v;
+}
+
+static void
+win_wind_sub(struct win_wind *p, const struct win_wind *q)
+{
+	p->count -= q->count;
+	p->u -= q->u;
+	p->v -= q->v;
+
+	if (p->count == 0) {
+		p->u = 0;
+		p->v = 0;
+	}
+}
+
+static void
+win_clear(struct win_wind *wind, struct win_stat *stat, size_t nfields)
+{
+	memset(wind, 0, sizeof(*wind));
+	memset(stat, 0, nfields * sizeof(*stat));
+}
+
+static void
+win_add(struct win_wind *wind, struct win_stat *stat, size_t nfields,
+		time_t t, const double *v, uint32_t mask, const struct win_wind *sample)
+{
+	size_t i;
+
+	for (i = 0; i < nfields; i++) {
+		if (mask & (1U << i)) {
+			win_stat_add(&stat[i], t, v[i]);
+		}
+	}
+
+	win_wind_merge(wind, sample);
+}
+
+/**
+ * Initializes the window pointed to by {@code w}.
+ *
+ * The {@code len} argument is the window length in seconds, or WIN_DAY for a
+ * calendar day.
+ */
+void
+window_init(struct window *w, long len, size_t nfields)
+{
+	memset(w, 0, window_size(len, nfields));
+
+	w->len = len;
+	w->width = (len == WIN_DAY) ? 0 : divup(len, WIN_BUCKETS);
+	w->nfields = nfields;
+}
+
+/**
+ * Initializes a wind vector of one sample.
+ *
+ * The direction {@code dir} is in degrees.
+ */
+void
+win_wind_init(struct win_wind *p, double speed, double dir)
+{
+	double rad = dir * M_PI / 180;
+
+	p->count = 1;
+	p->u = speed * sin(rad);
+	p->v = speed * cos(rad);
+}
+
+/**
+ * Computes the mean wind vector speed and direction (in degrees).
+ */
+int
+win_wind_mean(const struct win_wind *p, double *speed, double *dir)
+{
+	if (p->count == 0) {
+		errno = ENODATA;
+		return -1;
+	}
+
+	*speed = hypot(p->u, p->v) / p->count;
+	*dir = atan2(p->u, p->v) * 180 / M_PI;
+
+	if (*dir < 0) {
+		*dir += 360;
+	}
+
+	return 0;
+}
+
+static void
+window_day(struct window *w, time_t t)
+{
+	struct tm tm;
+
+	localtime_r(&t, &tm);
+	tm.tm_hour = 0;
+	tm.tm_min = 0;
+	tm.tm_sec = 0;
+	tm.tm_isdst = -1;
+	w->start = mktime(&tm);
+
+	tm.tm_mday++;
+	tm.tm_isdst = -1;
+	w->end = mktime(&tm);
+
+	win_clear(&w->wind, w->stat, w->nfields);
+}
+
+/**
+ * Recomputes the lowest and highest values of field {@code j} from the
+ * buckets.
+ */
+static void
+window_rescan(struct window *w, size_t j)
+{
+	size_t i;
+	struct win_stat *p = &w->stat[j];
+	int found = 0;
+
+	for (i = 0; i < WIN_BUCKETS; i++) {
+		const struct win_bucket *b = win_bucket_at(w, i);
+		const struct win_stat *q = &b->stat[j];
+
+		if (b->start == 0 || q->count == 0) {
+			continue;
+		}
+
+		if (!found || q->min < p->min) {
+			p->min = q->min;
+			p->min_time = q->min_time;
+		}
+		if (!found || p->max < q->max) {
+			p->max = q->max;
+			p->max_time = q->max_time;
+		}
+
+		found = 1;
+	}
+}
+
+/**
+ * Moves to the bucket starting at {@code start}, and removes the buckets
+ * that went out of the window from the window statistics.
+ *
+ * Sums and counts are updated in place; the lowest and highest values of a
+ * field are rescanned only when an expired bucket held them.
+ */
+static void
+window_roll(struct window *w, time_t start)
+{
+	size_t i, j, steps;
+	uint32_t rescan;
+
+	if (start < w->start || w->start == 0) {
+		steps = WIN_BUCKETS;
+	} else {
+		steps = min((start - w->start) / w->width, WIN_BUCKETS);
+	}
+
+	rescan = 0;
+
+	for (i = 0; i < steps; i++) {
+		struct win_bucket *b;
+
+		w->cur = (w->cur + 1) % WIN_BUCKETS;
+		b = win_bucket_at(w, w->cur);
+
+		if (b->start != 0) {
+			for (j = 0; j < w->nfields; j++) {
+				if (win_stat_sub(&w->stat[j], &b->stat[j])) {
+					rescan |= (1U << j);
+				}
+			}
+
+			win_wind_sub(&w->wind, &b->wind);
+		}
+
+		b->start = 0;
+		win_clear(&b->wind, b->stat, w->nfields);
+	}
+
+	win_bucket_at(w, w->cur)->start = start;
+	w->start = start;
+	w->end = start + w->width;
+
+	for (j = 0; j < w->nfields; j++) {
+		if (rescan & (1U << j)) {
+			window_rescan(w, j);
+		}
+	}
+}
+
+/**
+ * Removes from the window the samples older than its length, at time
+ * {@code t}. Samples are expired on push; this lets windows expire while no
+ * sample is pushed.
+ */
+void
+window_expire(struct window *w, time_t t)
+{
+	if (w->start == 0) {
+		return;
+	}
+
+	if (w->len == WIN_DAY) {
+		if (w->end <= t) {
+			window_day(w, t);
+		}
+	} else if (w->start < t - t % w->width) {
+		window_roll(w, t - t % w->width);
+	}
+}
+
+/**
+ * Adds a sample to the window.
+ *
+ * The {@code v} array holds the value of each field, valid when the matching
+ * bit of {@code mask} is set. The {@code wind} sample count is 0 if the wind
+ * is unknown.
+ */
+void
+window_push(struct window *w, time_t t, const double *v, uint32_t mask,
+		const struct win_wind *wind)
+{
+	if (w->len == WIN_DAY) {
+		if (t < w->start || w->end <= t) {
+			window_day(w, t);
+		}
+	} else {
+		struct win_bucket *b;
+		time_t start = t - t % w->width;
+
+		if (start != w->start) {
+			window_roll(w, start);
+		}
+
+		b = win_bucket_at(w, w->cur);
+		win_add(&b->wind, b->stat, w->nfields, t, v, mask, wind);
+	}
+
+	win_add(&w->wind, w->stat, w->nfields, t, v, mask, wind);
+}
@@ -0,0 +1,79 @@
+#ifndef _WINDOW_H
+#define _WINDOW_H
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+
+/*
+ * Rolling windows.
+ */
+
+#define WIN_MAX 8			/* Max number of windows */
+#define WIN_BUCKETS 60			/* Buckets per window */
+#define WIN_DAY 0			/* Calendar day length */
+
+/**
+ * Window statistics of a field.
+ *
+ * The mean value is {@code sum / count}.
+ */
+struct win_stat
+{
+	uint32_t count;			/* Number of values */
+	float min;			/* Lowest value */
+	float max;			/* Highest value */
+	time_t min_time;		/* Time of lowest value */
+	time_t max_time;		/* Time of highest value */
+	double sum;			/* Sum of values */
+};
+
+/**
+ * Wind vector sum.
+ */
+struct win_wind
+{
+	uint32_t count;			/* Number of samples */
+	double u;			/* Sum of east components */
+	double v;			/* Sum of north components */
+};
+
+/**
+ * Rolling window, of {@code nfields} fields.
+ *
+ * The window statistics are followed by WIN_BUCKETS buckets, each one
+ * covering 1/WIN_BUCKETS of the window length. Calendar day windows have
+ * no bucket.
+ */
+struct window
+{
+	long len;			/* Length, in seconds, or WIN_DAY */
+	time_t width;			/* Bucket width, in seconds */
+	time_t start;			/* Current bucket (or day) start */
+	time_t end;			/* Current bucket (or day) end */
+	size_t cur;			/* Current bucket */
+	size_t nfields;			/* Number of fields */
+
+	struct win_wind wind;		/* Wind vector */
+	struct win_stat stat[];		/* Field statistics */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t window_size(long len, size_t nfields);
+void window_init(struct window *w, long len, size_t nfields);
+
+void win_wind_init(struct win_wind *p, double speed, double dir);
+void window_push(struct window *w, time_t t, const double *v, uint32_t mask,
+		const struct win_wind *wind);
+void window_expire(struct window *w, time_t t);
+
+int win_wind_mean(const struct win_wind *p, double *speed, double *dir);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WINDOW_H */
@@ -7,30 +7,87 @@
 #endif
 
 #include <pthread.h>
+#include <sched.h>
 #include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
 #include <errno.h>
 #include <syslog.h>
 #include <string.h>
 #include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 
 #include "libws/defs.h"
 
 #include "board.h"
 #include "conf.h"
+#include "log.h"
 #include "db/sqlite.h"
+#include "queue.h"
 #include "service/util.h"
 #include "service/archive.h"
 #include "service/sensor.h"
-#include "service/ic.h"
-#include "service/sync.h"
-#include "service/wunder.h"
+#include "service/registry.h"
 #include "worker.h"
 
 #define sigrtno(i)	(SIGRTMIN + (i))
 
+#define QUEUE_NEL	32		/* Queued events per service */
+
+#define REACTOR_SIGNAL	UINT32_MAX	/* Reactor signal source */
+#define REACTOR_TICK	(UINT32_MAX - 1)	/* Reactor supervisor tick source */
+#define REACTOR_EVENTS	8		/* Reactor events per wait */
+
+/* Reactor source of service i: timer (0) or event queues (1) */
+#define reactor_src(i, q)	(((uint32_t) (i) << 1) | (q))
+
+#define SUPERVISOR_TICK		1	/* Supervisor period, in seconds */
+#define SUPERVISOR_BACKOFF	1	/* First retry delay, in seconds */
+#define SUPERVISOR_BACKOFF_MAX	60	/* Longest retry delay, in seconds */
+#define SUPERVISOR_TRIP		8	/* Failures suspending a service */
+#define SUPERVISOR_OPEN		300	/* Suspension time, in seconds */
+
+/* Sensor and archive services keep their cadence */
+#define SMALL_LOOPS		720	/* Small profile loop elements */
+#define SMALL_AR		288	/* Small profile archive elements */
+#define MEMORY_REPORT		60	/* Resident memory report, in ticks */
+
+#define worker_core(dt)		((dt) - threads < 2)
+
+/**
+ * Pipeline timestamps of a queued event (monotonic clock).
+ */
+struct sigevent_trace
+{
+	struct timespec origin;			/* Sample acquisition start */
+	struct timespec queued;			/* Notification */
+};
+
+struct sigevent_rt
+{
+	struct sigevent_trace trace;
+	struct ws_loop rt;
+};
+
+struct sigevent_ar
+{
+	struct sigevent_trace trace;
+	struct ws_archive ar;
+};
+
 struct worker
 {
+	const char *name;			/* Service name */
 	int signo;				/* Signal number */
 
 	int (*wmain)(void);			/* Simple thread runner */
@@ -42,11 +99,20 @@ struct worker
 	int (*ef_rt)(const struct ws_loop *);	/* Action on real-time sensor data */
 	int (*ef_ar)(const struct ws_archive *);	/* Action on archive data*/
 
-	struct ws_loop rt;
-	struct ws_archive ar;
+	int tfd;				/* Reactor timer */
+	enum queue_policy delivery;		/* Event delivery policy */
+	size_t qlen;				/* Event queue length */
+	int efd;				/* Event queues wakeup */
+	struct queue rtq;			/* Real-time sensor data queue */
+	struct queue arq;			/* Archive data queue */
 
+	struct ws_sched sched;			/* Thread options */
 	pthread_t tid;				/* Thread id */
+	atomic_int stop;			/* Stop requested */
+	atomic_int dead;			/* Stopped unexpectedly */
 	int failures;				/* Number of failures */
+	int nfail;				/* Consecutive failures */
+	struct timespec retry;			/* Backoff end (monotonic) */
 };
 
 static int startup = 1;
@@ -54,9 +120,16 @@ static int startup = 1;
 static volatile sig_atomic_t shutdown_pending;
 static volatile sig_atomic_t hangup_pending;
 
-static struct worker threads[8];	/* Daemon threads */
+static struct worker *threads;		/* Daemon threads */
 static size_t threads_nel;		/* Number of elements */
 
+/* Held to notify services, and to replace the queues of a service */
+static pthread_rwlock_t dispatch_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static int reactor_fd = -1;		/* Reactor epoll instance */
+static int (*conf_reread)(struct ws_conf *);	/* Reads configuration */
+static struct timespec sensor_last;	/* Last sensor timer expiration */
+
 static void
 sig_default(sigset_t *set)
 {
@@ -65,27 +138,63 @@ sig_default(sigset_t *set)
 	(void) sigaddset(set, SIGTERM);
 }
 
+/**
+ * Computes the timer setting {@code it} of the worker pointed to by
+ * {@code dt}, and returns its clock.
+ *
+ * Wall clock timers (SRV_TIMER_WALL) expire at multiples of their interval
+ * since the Epoch, plus their start value, on the real-time clock: the
+ * setting is then absolute. They stay aligned when the clock is stepped,
+ * missed expirations being merged. Other timers are relative to the
+ * monotonic clock.
+ */
+static clockid_t
+sigtimer_setting(const struct worker *dt, struct itimerspec *it)
+{
+	*it = dt->itimer;
+
+	if ((dt->flags & SRV_TIMER_WALL) && 0 < it->it_interval.tv_sec) {
+		struct timespec now;
+		time_t period = it->it_interval.tv_sec;
+		time_t offset = it->it_value.tv_sec % period;
+
+		(void) clock_gettime(CLOCK_REALTIME, &now);
+
+		/* Next boundary, plus offset */
+		it->it_value.tv_sec = now.tv_sec - (now.tv_sec - offset) % period + period;
+		it->it_value.tv_nsec = 0;
+
+		return CLOCK_REALTIME;
+	}
+
+	/* Adjust start value */
+	if (it->it_value.tv_sec == 0 && it->it_value.tv_nsec == 0) {
+		it->it_value.tv_nsec = 100;
+	}
+
+	return CLOCK_MONOTONIC;
+}
+
 static int
-sigtimer_create(int signo, struct itimerspec *it, timer_t *timer)
+sigtimer_create(const struct worker *dt, timer_t *timer)
 {
 	int errsv;
+	clockid_t clk;
 	struct sigevent se;
+	struct itimerspec it;
 
 	se.sigev_notify = SIGEV_SIGNAL;
-	se.sigev_signo = signo;
+	se.sigev_signo = dt->signo;
 	se.sigev_value.sival_ptr = timer;
 
-	/* Adjust start value */
-	if (it->it_value.tv_sec == 0 && it->it_value.tv_nsec == 0) {
-		it->it_value.tv_nsec = 100;
-	}
+	clk = sigtimer_setting(dt, &it);
 
-	if (timer_create(CLOCK_MONOTONIC, &se, timer) == -1) {
-		syslog(LOG_ERR, "timer_create: %m");
+	if (timer_create(clk, &se, timer) == -1) {
+		log_msg(LOG_ERR, "timer_create: %m");
 		return -1;
 	}
-	if (timer_settime(*timer, 0, it, NULL) == -1) {
-		syslog(LOG_ERR, "timer_settime: %m");
+	if (timer_settime(*timer, clk == CLOCK_REALTIME ? TIMER_ABSTIME : 0, &it, NULL) == -1) {
+		log_msg(LOG_ERR, "timer_settime: %m");
 		goto error;
 	}
 
@@ -93,17 +202,168 @@ sigtimer_create(int signo, struct itimerspec *it, timer_t *timer)
 
 error:
 	errsv = errno;
-	(void) timer_delete(&timer);
+	(void) timer_delete(*timer);
 
 	errno = errsv;
 	return -1;
 }
 
+/**
+ * Tells whether the retry time of the worker pointed to by {@code dt} is
+ * reached.
+ *
+ * A failing service is backed off until the retry time, which doubles on
+ * each consecutive failure. After SUPERVISOR_TRIP consecutive failures, the
+ * service is suspended for SUPERVISOR_OPEN seconds, and then given one event
+ * to recover.
+ */
+static int
+supervisor_ready(const struct worker *dt)
+{
+	struct timespec now;
+
+	if (dt->nfail == 0 || worker_core(dt)) {
+		return 1;
+	}
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return now.tv_sec > dt->retry.tv_sec
+		|| (now.tv_sec == dt->retry.tv_sec && now.tv_nsec >= dt->retry.tv_nsec);
+}
+
+/**
+ * Tells whether the worker pointed to by {@code dt} may handle an event.
+ * The event is skipped, and accounted as such, while the service is backed
+ * off.
+ */
+static int
+supervisor_allow(struct worker *dt)
+{
+	if (supervisor_ready(dt)) {
+		return 1;
+	}
+
+	board_stat_skip(dt - threads);
+
+	return 0;
+}
+
+static void
+supervisor_fail(struct worker *dt)
+{
+	long delay;
+	size_t i = dt - threads;
+
+	dt->failures++;
+	dt->nfail++;
+
+	if (worker_core(dt)) {
+		board_stat_health(i, BOARD_HEALTH_DEGRADED);
+		return;
+	}
+
+	if (dt->nfail < SUPERVISOR_TRIP) {
+		delay = min(SUPERVISOR_BACKOFF << (dt->nfail - 1), SUPERVISOR_BACKOFF_MAX);
+		board_stat_health(i, BOARD_HEALTH_DEGRADED);
+	} else {
+		delay = SUPERVISOR_OPEN;
+		board_stat_health(i, BOARD_HEALTH_OPEN);
+
+		if (dt->nfail == SUPERVISOR_TRIP) {
+			log_msg(LOG_WARNING, "Service %s suspended after %d failures",
+					dt->name, dt->nfail);
+		}
+	}
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &dt->retry);
+	dt->retry.tv_sec += delay;
+}
+
+static void
+supervisor_ok(struct worker *dt)
+{
+	if (dt->nfail) {
+		if (SUPERVISOR_TRIP <= dt->nfail) {
+			log_msg(LOG_NOTICE, "Service %s recovered", dt->name);
+		}
+
+		dt->nfail = 0;
+		board_stat_health(dt - threads, BOARD_HEALTH_OK);
+	}
+}
+
+/**
+ * Marks the worker pointed to by {@code dt} as stopped unexpectedly, for the
+ * supervisor to restart it.
+ */
+static void
+supervisor_dead(struct worker *dt)
+{
+	log_msg(LOG_ERR, "Service %s stopped unexpectedly", dt->name);
+
+	board_stat_health(dt - threads, BOARD_HEALTH_DEAD);
+	atomic_store(&dt->dead, 1);
+}
+
+static void
+sigevent_done(struct worker *dt, int ret, const struct timespec *start)
+{
+	board_stat_event(dt - threads, ret, start);
+
+	if (ret == -1) {
+		supervisor_fail(dt);
+	} else {
+		supervisor_ok(dt);
+	}
+}
+
+/**
+ * Handles the events queued to the worker pointed to by {@code dt}.
+ */
+static void
+sigevent_dispatch(struct worker *dt)
+{
+	uint64_t cnt;
+	size_t i = dt - threads;
+	struct timespec start;
+	struct sigevent_rt rt;
+	struct sigevent_ar ar;
+
+	/* Reset wakeup counter, before draining queues */
+	if (read(dt->efd, &cnt, sizeof(cnt)) == -1 && errno != EAGAIN) {
+		log_msg(LOG_ERR, "read: %m");
+	}
+
+	while (queue_pop(&dt->rtq, &rt) == 0) {
+		if (supervisor_allow(dt)) {
+			board_stat_wait(i, &rt.trace.queued);
+
+			(void) clock_gettime(CLOCK_MONOTONIC, &start);
+			sigevent_done(dt, dt->ef_rt(&rt.rt), &start);
+
+			board_stat_age(i, &rt.trace.origin);
+		}
+	}
+	while (queue_pop(&dt->arq, &ar) == 0) {
+		if (supervisor_allow(dt)) {
+			board_stat_wait(i, &ar.trace.queued);
+
+			(void) clock_gettime(CLOCK_MONOTONIC, &start);
+			sigevent_done(dt, dt->ef_ar(&ar.ar), &start);
+
+			board_stat_age(i, &ar.trace.origin);
+		}
+	}
+}
+
 static void *
 sigtimer_main(void *arg)
 {
 	int errsv;
+	int sfd;
 	struct worker *dt;
+	struct pollfd pfd[2];
 	sigset_t set;
 	timer_t timer;
 
@@ -113,49 +373,65 @@ sigtimer_main(void *arg)
 	(void) sigemptyset(&set);
 	(void) sigaddset(&set, dt->signo);
 
+	if ((sfd = signalfd(-1, &set, SFD_CLOEXEC)) == -1) {
+		log_msg(LOG_ERR, "signalfd: %m");
+		(void) dt->wdestroy();
+		supervisor_dead(dt);
+		return NULL;
+	}
+
 	/* Create timer */
 	if (dt->ef_timer) {
-		if (sigtimer_create(dt->signo, &dt->itimer, &timer) == -1) {
+		if (sigtimer_create(dt, &timer) == -1) {
 			goto error;
 		}
 	}
 
-	/* Signal notifications */
-	while (!shutdown_pending && !hangup_pending) {
-		siginfo_t info;
+	/* Timer signals and queued events */
+	pfd[0].fd = sfd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = dt->efd;
+	pfd[1].events = POLLIN;
 
-		if (sigwaitinfo(&set, &info) == -1) {
-			syslog(LOG_ERR, "sigwaitinfo: %m");
+	while (!shutdown_pending && !hangup_pending && !atomic_load(&dt->stop)) {
+		if (poll(pfd, 2, -1) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			log_msg(LOG_ERR, "poll: %m");
 			goto error;
-		} else {
-			if (hangup_pending || shutdown_pending) {
-				/* Stop requested */
-			} else {
-				int dt_ret = -1;
-				int si_code = info.si_code;
-
-				if (si_code == SI_TIMER) {
-					dt_ret = dt->ef_timer();
-				} else if (si_code == SI_QUEUE) {
-					int ef_code = info.si_value.sival_int;
-
-					if (ef_code == SRV_EVENT_RT) {
-						dt_ret = dt->ef_rt(&dt->rt);
-					} else if (ef_code == SRV_EVENT_AR) {
-						dt_ret = dt->ef_ar(&dt->ar);
-					}
-				}
+		}
 
-				if (dt_ret == -1) {
-					dt->failures++;
-				}
+		if (hangup_pending || shutdown_pending || atomic_load(&dt->stop)) {
+			/* Stop requested */
+			break;
+		}
+
+		if (pfd[0].revents & POLLIN) {
+			struct signalfd_siginfo info;
+
+			if (read(sfd, &info, sizeof(info)) == -1) {
+				log_msg(LOG_ERR, "read: %m");
+				goto error;
+			}
+
+			if (info.ssi_code == SI_TIMER && dt->ef_timer && supervisor_allow(dt)) {
+				struct timespec start;
+
+				(void) clock_gettime(CLOCK_MONOTONIC, &start);
+				sigevent_done(dt, dt->ef_timer(), &start);
 			}
 		}
+		if (pfd[1].revents & POLLIN) {
+			sigevent_dispatch(dt);
+		}
 	}
 
 	if (dt->ef_timer) {
-		(void) timer_delete(&timer);
+		(void) timer_delete(timer);
 	}
+	(void) close(sfd);
 
 	/* Cleanup */
 	if (dt->wdestroy() == -1) {
@@ -165,8 +441,12 @@ sigtimer_main(void *arg)
 
 error:
 	errsv = errno;
-	(void) timer_delete(&timer);
+	if (dt->ef_timer) {
+		(void) timer_delete(timer);
+	}
+	(void) close(sfd);
 	(void) dt->wdestroy();
+	supervisor_dead(dt);
 
 	errno = errsv;
 	return NULL;
@@ -179,10 +459,17 @@ sigthread_main(void *arg)
 
 	dt = (struct worker *) arg;
 
-	while (!shutdown_pending && !hangup_pending) {
-		if (dt->wmain() == -1) {
-			dt->failures++;
+	while (!shutdown_pending && !hangup_pending && !atomic_load(&dt->stop)) {
+		struct timespec start;
+
+		/* Wait for backoff end */
+		if (!supervisor_ready(dt)) {
+			(void) clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &dt->retry, NULL);
+			continue;
 		}
+
+		(void) clock_gettime(CLOCK_MONOTONIC, &start);
+		sigevent_done(dt, dt->wmain(), &start);
 	}
 
 	if (dt->wdestroy() == -1) {
@@ -191,9 +478,48 @@ sigthread_main(void *arg)
 	return NULL;
 }
 
+/**
+ * Applies the scheduling policy, priority and CPU affinity of the worker
+ * pointed to by {@code dt} to the thread {@code tid}. Failures (missing
+ * privileges, for example) are logged only.
+ */
+static void
+sigthread_sched(struct worker *dt, pthread_t tid)
+{
+	int ret;
+	struct sched_param param;
+
+	param.sched_priority = dt->sched.priority;
+
+	if ((ret = pthread_setschedparam(tid, dt->sched.policy, &param)) != 0) {
+		errno = ret;
+		log_msg(LOG_WARNING, "Service %s: pthread_setschedparam: %m", dt->name);
+	}
+
+	if (dt->sched.cpus) {
+		size_t i;
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+
+		for (i = 0; i < 8 * sizeof(dt->sched.cpus); i++) {
+			if (dt->sched.cpus & (1UL << i)) {
+				CPU_SET(i, &set);
+			}
+		}
+
+		if ((ret = pthread_setaffinity_np(tid, sizeof(set), &set)) != 0) {
+			errno = ret;
+			log_msg(LOG_WARNING, "Service %s: pthread_setaffinity_np: %m", dt->name);
+		}
+	}
+}
+
 static int
 sigthread_create(struct worker *dt)
 {
+	int ret;
+	pthread_attr_t attr;
 	void *(*func) (void *);
 
 	if (dt->wmain) {
@@ -202,11 +528,27 @@ sigthread_create(struct worker *dt)
 		func = sigtimer_main;
 	}
 
-	if (pthread_create(&dt->tid, NULL, func, dt) == -1) {
-		syslog(LOG_ERR, "pthread_create: %m");
+	(void) pthread_attr_init(&attr);
+
+	if (dt->sched.stack) {
+		if ((ret = pthread_attr_setstacksize(&attr, dt->sched.stack)) != 0) {
+			errno = ret;
+			log_msg(LOG_WARNING, "Service %s: pthread_attr_setstacksize: %m", dt->name);
+		}
+	}
+
+	ret = pthread_create(&dt->tid, &attr, func, dt);
+
+	(void) pthread_attr_destroy(&attr);
+
+	if (ret != 0) {
+		errno = ret;
+		log_msg(LOG_ERR, "pthread_create: %m");
 		return -1;
 	}
 
+	sigthread_sched(dt, dt->tid);
+
 	return 0;
 }
 
@@ -218,19 +560,19 @@ sigthread_kill(struct worker *dt)
 	/* Kill thread */
 	if (dt->wmain) {
 		if (pthread_cancel(dt->tid) == -1) {
-			syslog(LOG_ERR, "pthread_cancel: %m");
+			log_msg(LOG_ERR, "pthread_cancel: %m");
 			goto error;
 		}
 	} else {
 		if (pthread_kill(dt->tid, dt->signo) == -1) {
-			syslog(LOG_ERR, "pthread_kill %d: %m", dt->signo);
+			log_msg(LOG_ERR, "pthread_kill %d: %m", dt->signo);
 			goto error;
 		}
 	}
 
 	/* Wait for thread to complete */
 	if (pthread_join(dt->tid, &th_res) == -1) {
-		syslog(LOG_ERR, "pthread_join: %m");
+		log_msg(LOG_ERR, "pthread_join: %m");
 		goto error;
 	}
 
@@ -240,28 +582,82 @@ error:
 	return -1;
 }
 
+/**
+ * Queues the event pointed to by {@code p} to the worker pointed to by
+ * {@code dt}.
+ *
+ * The producer never waits for the worker: when the queue is full, an event
+ * is dropped (or replaced, for latest-only delivery) according to the
+ * worker delivery policy, and accounted on the board.
+ */
+static void
+sigevent_notify(struct worker *dt, struct queue *q, const void *p)
+{
+	int ret = queue_push(q, p);
+
+	if (ret == -1) {
+		board_stat_drop(dt - threads);
+	} else if (ret == 1) {
+		if (dt->delivery == QUEUE_LATEST) {
+			board_stat_coalesce(dt - threads);
+		} else {
+			board_stat_drop(dt - threads);
+		}
+	}
+}
+
+static long long
+timespec_ms(struct timespec *ts)
+{
+	return ts->tv_sec * 1000 + ts->tv_nsec / 1000000;
+}
+
+static long long
+timespec_us(struct timespec *ts)
+{
+	return ts->tv_sec * 1000000LL + ts->tv_nsec / 1000;
+}
+
 static int
 sigevent_sensor()
 {
 	int ret;
-	struct ws_loop rt;
+	struct sigevent_rt ev;
 
-	ret = sensor_sig_timer(&rt);
+	(void) clock_gettime(CLOCK_MONOTONIC, &ev.trace.origin);
+
+	/* Timer jitter: deviation from the sensor interval */
+	if (sensor_last.tv_sec != 0) {
+		long long us;
+
+		us = (ev.trace.origin.tv_sec - sensor_last.tv_sec) * 1000000LL
+				+ (ev.trace.origin.tv_nsec - sensor_last.tv_nsec) / 1000
+				- timespec_us(&threads[0].itimer.it_interval);
+
+		board_stat_sample(BOARD_HIST_JITTER, us < 0 ? -us : us);
+	}
+
+	sensor_last = ev.trace.origin;
+
+	ret = sensor_sig_timer(&ev.rt);
 
 	/* Notify other threads */
 	if (ret == 0) {
 		int i;
 
+		(void) clock_gettime(CLOCK_MONOTONIC, &ev.trace.queued);
+		(void) pthread_rwlock_rdlock(&dispatch_lock);
+
 		for (i = 0; i < threads_nel; i++) {
 			struct worker *dt = &threads[i];
 
 			if (dt->flags & SRV_EVENT_RT) {
-				union sigval val = { SRV_EVENT_RT };
-
-				memcpy(&dt->rt, &rt, sizeof(rt));
-				pthread_sigqueue(dt->tid, dt->signo, val);
+				sigevent_notify(dt, &dt->rtq, &ev);
 			}
 		}
+
+		(void) pthread_rwlock_unlock(&dispatch_lock);
+		board_stat_time(BOARD_HIST_DISPATCH, &ev.trace.queued);
 	}
 
 	return ret;
@@ -271,36 +667,44 @@ static int
 sigevent_archive()
 {
 	int ret;
-	struct ws_archive ar;
+	struct sigevent_ar ev;
 
-	ret = archive_sig_timer(&ar);
+	(void) clock_gettime(CLOCK_MONOTONIC, &ev.trace.origin);
+
+	ret = archive_sig_timer(&ev.ar);
 
 	/* Notify other threads */
-	if (ret == 0) {
+	if (ret > 0) {
 		int i;
 
+		(void) clock_gettime(CLOCK_MONOTONIC, &ev.trace.queued);
+		(void) pthread_rwlock_rdlock(&dispatch_lock);
+
 		for (i = 0; i < threads_nel; i++) {
 			struct worker *dt = &threads[i];
 
-			if (threads[i].flags & SRV_EVENT_AR) {
-				union sigval val = { SRV_EVENT_AR };
-
-				memcpy(&dt->ar, &ar, sizeof(ar));
-				pthread_sigqueue(dt->tid, dt->signo, val);
+			if (dt->flags & SRV_EVENT_AR) {
+				sigevent_notify(dt, &dt->arq, &ev);
 			}
 		}
+
+		(void) pthread_rwlock_unlock(&dispatch_lock);
+		board_stat_time(BOARD_HIST_DISPATCH, &ev.trace.queued);
 	}
 
-	return ret;
-}
+	/* Records the database writer failed to save */
+	if (archive_lost() > 0) {
+		ret = -1;
+	}
 
-static long long
-timespec_ms(struct timespec *ts)
-{
-	return ts->tv_sec * 1000 + ts->tv_nsec / 1000000;
+	return ret;
 }
 
 
+/**
+ * Computes the default number of loop elements on the board: enough to cover
+ * the longest service interval.
+ */
 static size_t
 nloops_count()
 {
@@ -325,26 +729,137 @@ nloops_count()
 	return divup(duration, step);
 }
 
+/**
+ * Computes the board capacity, from the configured loop and archive history,
+ * for board flags {@code flags}.
+ */
+static void
+board_count(size_t *nloops, size_t *nar, int flags)
+{
+	long long step;
+
+	/* Loop elements */
+	step = timespec_ms(&threads[0].itimer.it_interval);
+
+	if (confp->board.loop_history == 0 || step == 0) {
+		*nloops = nloops_count();
+	} else {
+		*nloops = divup(confp->board.loop_history * 1000, step);
+	}
+
+	/* Archive elements */
+	step = threads[1].itimer.it_interval.tv_sec;
+
+	if (confp->board.ar_history == 0 || step == 0) {
+		*nar = 1;
+	} else {
+		*nar = divup(confp->board.ar_history, step);
+	}
+
+	if (*nloops == 0) {
+		*nloops = 1;
+	}
+
+	/* Board budget, columns included */
+	if (confp->worker.profile == PROFILE_SMALL) {
+		size_t nmax = SMALL_LOOPS * board_loop_size(flags & ~BOARD_COLUMNS)
+			/ board_loop_size(flags);
+
+		*nloops = min(*nloops, nmax);
+		*nar = min(*nar, SMALL_AR);
+	}
+}
+
+static int
+srv_nop(void)
+{
+	return 0;
+}
+
+/**
+ * Initializes the worker pointed to by {@code dt}, running the service
+ * pointed to by {@code srv}.
+ */
+static int
+service_init(struct worker *dt, const struct service *srv)
+{
+	struct service_opts opts;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.delivery = QUEUE_ALL;
+	opts.queue = QUEUE_NEL;
+
+	if (srv->init(&opts) == -1) {
+		log_msg(LOG_ERR, "Service %s initialization failed", srv->name);
+		return -1;
+	}
+
+	if (opts.queue < 1) {
+		log_msg(LOG_ERR, "Service %s: invalid queue length", srv->name);
+		goto error;
+	}
+	if ((opts.flags & SRV_EVENT_RT && srv->on_loop == NULL)
+			|| (opts.flags & SRV_EVENT_AR && srv->on_archive == NULL)) {
+		log_msg(LOG_ERR, "Service %s: missing event handler", srv->name);
+		goto error;
+	}
+
+	dt->name = srv->name;
+	dt->flags = opts.flags;
+	dt->itimer = opts.itimer;
+	dt->delivery = opts.delivery;
+	dt->qlen = opts.queue;
+	dt->sched = opts.sched;
+	dt->ef_timer = srv->on_timer;
+	dt->ef_rt = srv->on_loop;
+	dt->ef_ar = srv->on_archive;
+	dt->wdestroy = srv->destroy ? srv->destroy : srv_nop;
+
+	return 0;
+
+error:
+	if (srv->destroy) {
+		(void) srv->destroy();
+	}
+	return -1;
+}
+
 static int
 threads_init(void)
 {
-	int i;
+	size_t i, j;
+
+	if (registry_init() == -1) {
+		return -1;
+	}
 
-	threads_nel = 2;
-	memset(threads, 0, sizeof(threads));
+	/* Sensor and archive, then registered services */
+	threads_nel = 2 + registry_count();
 
-	if (confp->sync.enabled) {
-		threads_nel++;
+	if (SIGRTMAX < sigrtno(threads_nel - 1)) {
+		log_msg(LOG_ERR, "Too many services: %zu", threads_nel);
+		threads_nel = 0;
+		return -1;
 	}
-	if (confp->stat_ic.enabled) {
-		threads_nel++;
+
+	/* The board keeps counters for a fixed number of services */
+	if (BOARD_SRV_MAX < threads_nel) {
+		log_msg(LOG_WARNING, "Too many services: statistics kept for the first %d only",
+				BOARD_SRV_MAX);
 	}
-	if (confp->wunder.enabled) {
-		threads_nel++;
+
+	if ((threads = calloc(threads_nel, sizeof(*threads))) == NULL) {
+		log_msg(LOG_ERR, "calloc: %m");
+		threads_nel = 0;
+		return -1;
 	}
 
 	for (i = 0; i < threads_nel; i++) {
 		threads[i].tid = (pthread_t) -1;
+		threads[i].tfd = -1;
+		threads[i].efd = -1;
+		threads[i].signo = sigrtno(i);
+		threads[i].wdestroy = srv_nop;
 	}
 
 	i = 0;
@@ -353,7 +868,9 @@ threads_init(void)
 	if (sensor_init(&threads[i].itimer) == -1) {
 		goto error;
 	}
-	threads[i].signo = sigrtno(i);
+	sensor_last.tv_sec = 0;
+	threads[i].name = "sensor";
+	threads[i].sched = confp->driver.sched;
 	threads[i].ef_timer = sigevent_sensor;
 	threads[i].wdestroy = sensor_destroy;
 
@@ -363,58 +880,94 @@ threads_init(void)
 	if (archive_init(&threads[i].itimer) == -1) {
 		goto error;
 	}
-	threads[i].signo = sigrtno(i);
+	threads[i].name = "archive";
+	threads[i].sched = confp->archive.sched;
+	threads[i].flags = SRV_TIMER_WALL;
 	threads[i].ef_timer = sigevent_archive;
 	threads[i].wdestroy = archive_destroy;
 
 	i++;
 
-	/* Time synchronization */
-	if (confp->sync.enabled) {
-		if (sync_init(&threads[i].flags, &threads[i].itimer) == -1) {
+	/* Registered services */
+	for (j = 0; j < registry_count(); j++, i++) {
+		if (service_init(&threads[i], registry_get(j)) == -1) {
 			goto error;
 		}
-		threads[i].signo = sigrtno(i);
-		threads[i].ef_timer = sync_sig_timer;
-		threads[i].wdestroy = sync_destroy;
+	}
 
-		i++;
-	} else {
-		syslog(LOG_WARNING, "Console time synchronization disabled");
+	return 0;
+
+error:
+	/* Release initialized services */
+	while (i-- > 0) {
+		(void) threads[i].wdestroy();
+		threads[i].wdestroy = srv_nop;
 	}
+	return -1;
+}
 
-	/* StatIC */
-	if (confp->stat_ic.enabled) {
-		if (ic_init(&threads[i].flags, &threads[i].itimer) == -1) {
-			goto error;
+/**
+ * Creates the event queues of the worker pointed to by {@code dt}.
+ */
+static int
+queues_init(struct worker *dt)
+{
+	if (dt->flags & (SRV_EVENT_RT | SRV_EVENT_AR)) {
+		if ((dt->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			log_msg(LOG_ERR, "eventfd: %m");
+			return -1;
 		}
+	}
 
-		threads[i].signo = sigrtno(i);
-		threads[i].ef_ar = ic_sig_ar;
-		threads[i].ef_rt = ic_sig_rt;
-		threads[i].wdestroy = ic_destroy;
+	if (dt->flags & SRV_EVENT_RT) {
+		if (queue_init(&dt->rtq, dt->qlen, sizeof(struct sigevent_rt), dt->efd,
+				dt->delivery) == -1) {
+			log_msg(LOG_ERR, "queue_init: %m");
+			return -1;
+		}
+	}
+	if (dt->flags & SRV_EVENT_AR) {
+		if (queue_init(&dt->arq, dt->qlen, sizeof(struct sigevent_ar), dt->efd,
+				dt->delivery) == -1) {
+			log_msg(LOG_ERR, "queue_init: %m");
+			return -1;
+		}
+	}
 
-		i++;
+	return 0;
+}
+
+static void
+queues_destroy(struct worker *dt)
+{
+	queue_destroy(&dt->rtq);
+	queue_destroy(&dt->arq);
+
+	if (dt->efd != -1) {
+		(void) close(dt->efd);
+		dt->efd = -1;
 	}
+}
 
-	/* Wunderground */
-	if (confp->wunder.enabled) {
-		if (wunder_init(&threads[i].flags, &threads[i].itimer) == -1) {
-			goto error;
-		}
+/**
+ * Registers services on the board, and creates their event queues.
+ */
+static int
+services_create(void)
+{
+	size_t i;
 
-		threads[i].signo = sigrtno(i);
-		threads[i].ef_timer = wunder_sig_timer;
-		threads[i].wdestroy = wunder_destroy;
+	for (i = 0; i < threads_nel; i++) {
+		struct worker *dt = &threads[i];
 
-		i++;
+		board_stat_register(i, dt->name);
+
+		if (queues_init(dt) == -1) {
+			return -1;
+		}
 	}
 
 	return 0;
-
-error:
-	// TODO: cleanup
-	return -1;
 }
 
 static int
@@ -434,17 +987,22 @@ threads_create(void)
 		return -1;
 	}
 
+	/* Event queues */
+	if (services_create() == -1) {
+		return -1;
+	}
+
 	/* Create threads */
 	for (i = 0; i < threads_nel; i++) {
 		struct worker *dt = &threads[i];
 
 		if (sigthread_create(dt) == -1) {
-			syslog(LOG_ERR, "pthread_create: %m");
+			log_msg(LOG_ERR, "pthread_create: %m");
 			return -1;
 		}
 	}
 
-	syslog(LOG_INFO, "%zd threads running", threads_nel);
+	log_msg(LOG_INFO, "%zd threads running", threads_nel);
 
 	return 0;
 }
@@ -467,6 +1025,8 @@ threads_kill(void)
 
 			dt->tid = (pthread_t) -1;
 		}
+
+		queues_destroy(dt);
 	}
 
 	return ret;
@@ -478,7 +1038,7 @@ worker_destroy(void)
 	int ret = 0;
 
 	threads_kill();
-	syslog(LOG_INFO, "Threads stopped");
+	log_msg(LOG_INFO, "Threads stopped");
 
 	/* Shutdown requested */
 	if (shutdown_pending) {
@@ -487,24 +1047,571 @@ worker_destroy(void)
 			ret = -1;
 		}
 
-		syslog(LOG_INFO, "Resources released");
+		log_msg(LOG_INFO, "Resources released");
 	}
 
 	if (drv_destroy() == -1) {
 		ret = -1;
 	}
 
+	/* Services */
+	free(threads);
+	threads = NULL;
+	threads_nel = 0;
+
+	registry_clear();
+
 	return ret;
 }
 
+static int reactor_watch(size_t i);
+static void reactor_unwatch(struct worker *dt);
+
+static void
+service_disable(struct worker *dt)
+{
+	dt->flags = 0;
+	dt->ef_timer = NULL;
+	dt->ef_rt = NULL;
+	dt->ef_ar = NULL;
+	dt->wdestroy = srv_nop;
+}
+
+/**
+ * Initializes again the registered service of worker {@code i}, with the
+ * options of {@code cfg}. The service shall be stopped.
+ *
+ * On failure, the service is left disabled.
+ */
+static int
+service_reload(size_t i, struct ws_conf *cfg)
+{
+	int ret;
+	struct worker *dt = &threads[i];
+
+	(void) pthread_rwlock_wrlock(&dispatch_lock);
+
+	queues_destroy(dt);
+	service_disable(dt);
+	registry_apply(i - 2, cfg);
+
+	if ((ret = service_init(dt, registry_get(i - 2))) == 0) {
+		if ((ret = queues_init(dt)) == -1) {
+			(void) dt->wdestroy();
+			queues_destroy(dt);
+			service_disable(dt);
+		}
+	}
+
+	(void) pthread_rwlock_unlock(&dispatch_lock);
+
+	if (ret == 0) {
+		board_stat_register(i, dt->name);
+		board_stat_health(i, dt->nfail ? BOARD_HEALTH_DEGRADED : BOARD_HEALTH_OK);
+	} else {
+		board_stat_health(i, BOARD_HEALTH_DISABLED);
+	}
+
+	return ret;
+}
+
+static int
+thread_restart(size_t i, struct ws_conf *cfg)
+{
+	struct worker *dt = &threads[i];
+
+	if (dt->tid != (pthread_t) -1) {
+		atomic_store(&dt->stop, 1);
+
+		if (sigthread_kill(dt) == -1) {
+			return -1;
+		}
+
+		dt->tid = (pthread_t) -1;
+		atomic_store(&dt->stop, 0);
+	}
+
+	/* Fresh options, fresh backoff */
+	atomic_store(&dt->dead, 0);
+	dt->nfail = 0;
+
+	if (service_reload(i, cfg) == -1) {
+		return -1;
+	}
+
+	return sigthread_create(dt);
+}
+
+static int
+reactor_restart(size_t i, struct ws_conf *cfg)
+{
+	struct worker *dt = &threads[i];
+
+	reactor_unwatch(dt);
+	(void) dt->wdestroy();
+
+	dt->nfail = 0;
+
+	if (service_reload(i, cfg) == -1) {
+		return -1;
+	}
+
+	return reactor_watch(i);
+}
+
+/**
+ * Restarts the services that stopped unexpectedly, once their backoff time
+ * elapsed. A full restart is requested if the sensor or archive service
+ * stopped.
+ */
+static void
+supervisor_check(void)
+{
+	size_t i;
+
+	for (i = 0; i < threads_nel; i++) {
+		struct worker *dt = &threads[i];
+
+		if (!atomic_load(&dt->dead)) {
+			continue;
+		}
+
+		if (worker_core(dt)) {
+			log_msg(LOG_CRIT, "Service %s stopped, restarting", dt->name);
+			hangup_pending = 1;
+			return;
+		}
+
+		/* Reap thread */
+		if (dt->tid != (pthread_t) -1) {
+			(void) pthread_join(dt->tid, NULL);
+			dt->tid = (pthread_t) -1;
+
+			supervisor_fail(dt);
+			board_stat_health(i, BOARD_HEALTH_DEAD);
+		}
+
+		/* Restart after backoff */
+		if (supervisor_ready(dt)) {
+			board_stat_restart(i);
+
+			atomic_store(&dt->dead, 0);
+
+			if (service_reload(i, confp) == -1 || sigthread_create(dt) == -1) {
+				log_msg(LOG_ERR, "Service %s not restarted", dt->name);
+
+				dt->tid = (pthread_t) -1;
+				atomic_store(&dt->dead, 1);
+
+				supervisor_fail(dt);
+				board_stat_health(i, BOARD_HEALTH_DISABLED);
+			} else {
+				log_msg(LOG_NOTICE, "Service %s restarted", dt->name);
+			}
+		}
+	}
+}
+
+/**
+ * Reads the resident memory size, in kB.
+ */
+static long
+memory_rss(void)
+{
+	int fd;
+	ssize_t sz;
+	long size, resident;
+	char buf[128];
+
+	if ((fd = open("/proc/self/statm", O_RDONLY)) == -1) {
+		return -1;
+	}
+
+	sz = read(fd, buf, sizeof(buf) - 1);
+	(void) close(fd);
+
+	if (sz <= 0) {
+		return -1;
+	}
+
+	buf[sz] = 0;
+	if (sscanf(buf, "%ld %ld", &size, &resident) != 2) {
+		return -1;
+	}
+
+	return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+/**
+ * Publishes the memory counters. The resident memory is logged once,
+ * MEMORY_REPORT ticks after startup.
+ */
+static void
+memory_check(void)
+{
+	static unsigned int ticks = 0;
+	long rss;
+	struct rusage ru;
+
+	rss = memory_rss();
+	if (getrusage(RUSAGE_SELF, &ru) == -1 || ru.ru_maxrss < rss) {
+		ru.ru_maxrss = rss;
+	}
+
+	board_stat_memory(rss, ru.ru_maxrss);
+
+	if (++ticks == MEMORY_REPORT) {
+		log_msg(LOG_INFO, "Resident memory: %ldkB (peak %ldkB)", rss, ru.ru_maxrss);
+	}
+}
+
+/**
+ * Publishes the logging and memory counters.
+ */
+static void
+stats_check(void)
+{
+	struct log_stats st;
+
+	log_stats(&st);
+	board_stat_log(st.logged, st.repeated, st.dropped);
+
+	memory_check();
+}
+
+/**
+ * Reloads the configuration, and restarts the services whose options
+ * changed. The sensor and archive services, the device and the database are
+ * left untouched, unless core options changed: a full restart is then
+ * requested.
+ *
+ * If the configuration cannot be read, the current one is kept.
+ */
+static void
+worker_reload(void)
+{
+	size_t i;
+	struct ws_conf cfg;
+
+	if (conf_reread == NULL) {
+		hangup_pending = 1;
+		return;
+	}
+	if (conf_reread(&cfg) == -1) {
+		log_msg(LOG_ERR, "Configuration not reloaded");
+		return;
+	}
+
+	/* Clients stay attached to the open board */
+	if (conf_changed(&cfg, CONF_BOARD)) {
+		log_msg(LOG_WARNING, "Board options changed, applied on process restart");
+	}
+
+	if (conf_changed(&cfg, CONF_CORE)) {
+		log_msg(LOG_NOTICE, "Core options changed, restarting");
+		hangup_pending = 1;
+		conf_dispose(&cfg);
+		return;
+	}
+
+	conf_apply(&cfg, CONF_CORE);
+	(void) log_setmask(LOG_UPTO(confp->log_level));
+
+	for (i = 2; i < threads_nel; i++) {
+		int ret;
+
+		if (!registry_changed(i - 2, &cfg)) {
+			continue;
+		}
+
+		if (confp->worker.engine == ENGINE_REACTOR) {
+			ret = reactor_restart(i, &cfg);
+		} else {
+			ret = thread_restart(i, &cfg);
+		}
+
+		if (ret == -1) {
+			log_msg(LOG_ERR, "Service %s stopped", registry_get(i - 2)->name);
+		} else {
+			log_msg(LOG_INFO, "Service %s restarted", threads[i].name);
+		}
+	}
+
+	/* Options not applied, and replaced ones */
+	conf_dispose(&cfg);
+
+	log_msg(LOG_NOTICE, "Configuration reloaded");
+}
+
+static void
+reactor_destroy(int sfd, int tfd)
+{
+	size_t i;
+
+	for (i = 0; i < threads_nel; i++) {
+		struct worker *dt = &threads[i];
+
+		if (dt->tfd != -1) {
+			(void) close(dt->tfd);
+			dt->tfd = -1;
+		}
+
+		(void) dt->wdestroy();
+	}
+
+	if (sfd != -1) {
+		(void) close(sfd);
+	}
+	if (tfd != -1) {
+		(void) close(tfd);
+	}
+	if (reactor_fd != -1) {
+		(void) close(reactor_fd);
+		reactor_fd = -1;
+	}
+}
+
+static void
+sigmain(int signo)
+{
+	switch (signo) {
+	case SIGHUP:
+		log_msg(LOG_NOTICE, "Signal HUP received");
+		worker_reload();
+		break;
+	case SIGTERM:
+		shutdown_pending = 1;
+		log_msg(LOG_NOTICE, "Signal TERM received");
+		break;
+	default:
+		log_msg(LOG_ERR, "Signal %d received", signo);
+		break;
+	}
+}
+
+static int
+reactor_add(int epfd, int fd, uint32_t src)
+{
+	struct epoll_event ev;
+
+	ev.events = EPOLLIN;
+	ev.data.u32 = src;
+
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		log_msg(LOG_ERR, "epoll_ctl: %m");
+		return -1;
+	}
+
+	return 0;
+}
+
+static int
+reactor_timer(struct worker *dt)
+{
+	clockid_t clk;
+	struct itimerspec it;
+
+	clk = sigtimer_setting(dt, &it);
+
+	if ((dt->tfd = timerfd_create(clk, TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+		log_msg(LOG_ERR, "timerfd_create: %m");
+		return -1;
+	}
+	if (timerfd_settime(dt->tfd, clk == CLOCK_REALTIME ? TFD_TIMER_ABSTIME : 0, &it, NULL) == -1) {
+		log_msg(LOG_ERR, "timerfd_settime: %m");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Watches the timer and event queues of worker {@code i}.
+ */
+static int
+reactor_watch(size_t i)
+{
+	struct worker *dt = &threads[i];
+
+	if (dt->wmain) {
+		log_msg(LOG_ERR, "Service %s cannot run in reactor", dt->name);
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (dt->ef_timer) {
+		if (reactor_timer(dt) == -1) {
+			return -1;
+		}
+		if (reactor_add(reactor_fd, dt->tfd, reactor_src(i, 0)) == -1) {
+			return -1;
+		}
+	}
+	if (dt->efd != -1) {
+		if (reactor_add(reactor_fd, dt->efd, reactor_src(i, 1)) == -1) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void
+reactor_unwatch(struct worker *dt)
+{
+	if (dt->tfd != -1) {
+		(void) epoll_ctl(reactor_fd, EPOLL_CTL_DEL, dt->tfd, NULL);
+		(void) close(dt->tfd);
+		dt->tfd = -1;
+	}
+	if (dt->efd != -1) {
+		(void) epoll_ctl(reactor_fd, EPOLL_CTL_DEL, dt->efd, NULL);
+	}
+}
+
+static void
+reactor_run(uint32_t src)
+{
+	struct worker *dt = &threads[src >> 1];
+
+	if (src & 1) {
+		if (dt->efd != -1) {
+			sigevent_dispatch(dt);
+		}
+	} else if (dt->tfd != -1) {
+		uint64_t exp;
+		struct timespec start;
+
+		/* Missed expirations are merged */
+		if (read(dt->tfd, &exp, sizeof(exp)) == -1) {
+			return;
+		}
+		if (!supervisor_allow(dt)) {
+			return;
+		}
+
+		(void) clock_gettime(CLOCK_MONOTONIC, &start);
+		sigevent_done(dt, dt->ef_timer(), &start);
+	}
+}
+
+/**
+ * Runs all services from the calling thread, until a stop is requested.
+ *
+ * Timers are timerfds, and event queues and the signals in {@code set} are
+ * watched with the same epoll instance. Services run one at a time. The
+ * supervisor tick is a timerfd as well, which replaces the signal wait
+ * timeout of the threaded engine.
+ */
+static int
+reactor_main(const sigset_t *set)
+{
+	int errsv;
+	int sfd, tfd;
+	size_t i;
+	struct itimerspec tick = { { SUPERVISOR_TICK, 0 }, { SUPERVISOR_TICK, 0 } };
+
+	sfd = -1;
+	tfd = -1;
+
+	if (services_create() == -1) {
+		goto error;
+	}
+
+	/* Sensor thread options apply to the reactor */
+	sigthread_sched(&threads[0], pthread_self());
+
+	if ((reactor_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		log_msg(LOG_ERR, "epoll_create1: %m");
+		goto error;
+	}
+	if ((sfd = signalfd(-1, set, SFD_CLOEXEC)) == -1) {
+		log_msg(LOG_ERR, "signalfd: %m");
+		goto error;
+	}
+	if (reactor_add(reactor_fd, sfd, REACTOR_SIGNAL) == -1) {
+		goto error;
+	}
+
+	/* Supervisor tick */
+	if ((tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+		log_msg(LOG_ERR, "timerfd_create: %m");
+		goto error;
+	}
+	if (timerfd_settime(tfd, 0, &tick, NULL) == -1) {
+		log_msg(LOG_ERR, "timerfd_settime: %m");
+		goto error;
+	}
+	if (reactor_add(reactor_fd, tfd, REACTOR_TICK) == -1) {
+		goto error;
+	}
+
+	for (i = 0; i < threads_nel; i++) {
+		if (reactor_watch(i) == -1) {
+			goto error;
+		}
+	}
+
+	log_msg(LOG_INFO, "%zd services running", threads_nel);
+
+	/* Wait for events */
+	while (!shutdown_pending && !hangup_pending) {
+		int n, j;
+		struct epoll_event ev[REACTOR_EVENTS];
+
+		if ((n = epoll_wait(reactor_fd, ev, REACTOR_EVENTS, -1)) == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			log_msg(LOG_ERR, "epoll_wait: %m");
+			goto error;
+		}
+
+		for (j = 0; j < n && !shutdown_pending && !hangup_pending; j++) {
+			if (ev[j].data.u32 == REACTOR_SIGNAL) {
+				struct signalfd_siginfo info;
+
+				if (read(sfd, &info, sizeof(info)) == -1) {
+					log_msg(LOG_ERR, "read: %m");
+					goto error;
+				}
+
+				sigmain(info.ssi_signo);
+			} else if (ev[j].data.u32 == REACTOR_TICK) {
+				uint64_t exp;
+
+				/* Missed ticks are merged */
+				if (read(tfd, &exp, sizeof(exp)) != -1) {
+					stats_check();
+				}
+			} else {
+				reactor_run(ev[j].data.u32);
+			}
+		}
+	}
+
+	reactor_destroy(sfd, tfd);
+
+	return 0;
+
+error:
+	errsv = errno;
+	reactor_destroy(sfd, tfd);
+
+	errno = errsv;
+	return -1;
+}
+
 int
-worker_main(int *halt)
+worker_main(int (*reread)(struct ws_conf *), int *halt)
 {
 	int errsv;
 	sigset_t set;
 
 	shutdown_pending = 0;
 	hangup_pending = 0;
+	conf_reread = reread;
 
 	sig_default(&set);
 
@@ -521,54 +1628,82 @@ worker_main(int *halt)
 		ssize_t sz;
 		size_t nloops;
 		size_t nar;
+		int flags;
 
 		if (pthread_sigmask(SIG_BLOCK, &set, NULL) == -1) {
-			syslog(LOG_ERR, "pthread_sigmask: %m");
+			log_msg(LOG_ERR, "pthread_sigmask: %m");
 			goto error;
 		}
 
-		nloops = nloops_count();
-		nar = 1;
+		flags = confp->board.packed ? BOARD_PACKED : 0;
+		if (confp->board.columns) {
+			flags |= BOARD_COLUMNS;
+		}
+
+		board_count(&nloops, &nar, flags);
 
-		if ((sz = board_open(O_CREAT, nloops, nar)) == -1) {
-			syslog(LOG_ERR, "board_open: %m");
+		sz = board_open(confp->station.name, confp->board.file, O_CREAT,
+				nloops, nar, flags, confp->board.windows, confp->board.nwindows);
+		if (sz == -1) {
+			log_msg(LOG_ERR, "board_open: %m");
 			goto error;
 		}
 
 		startup = 0;
 
-		syslog(LOG_INFO, "Allocated %zdkB for shared board", sz / 1024);
+		log_msg(LOG_INFO, "Allocated %zdkB for shared board (%zu loops, %zu archives)",
+				sz / 1024, nloops, nar);
+
+		if (board_restored()) {
+			log_msg(LOG_NOTICE, "Shared board restored from %s", confp->board.file);
+		}
 	}
 
-	/* Start all workers */
-	if (threads_create() == -1) {
-		syslog(LOG_ERR, "threads_start: %m");
+	/* Keep memory resident, to avoid page faults in the sensor path */
+	if (confp->worker.mlock) {
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1) {
+			log_msg(LOG_WARNING, "mlockall: %m");
+		}
+	} else {
+		(void) munlockall();
+	}
+
+	/* Fetch missed archives in background */
+	if (archive_start() == -1) {
 		goto error;
 	}
 
+	/* Single-threaded engine */
+	if (confp->worker.engine == ENGINE_REACTOR) {
+		if (reactor_main(&set) == -1) {
+			log_msg(LOG_ERR, "reactor_main: %m");
+			goto error;
+		}
+	} else {
+		/* Start all workers */
+		if (threads_create() == -1) {
+			log_msg(LOG_ERR, "threads_start: %m");
+			goto error;
+		}
+	}
+
 	/* Wait for events */
 	while (!shutdown_pending && !hangup_pending) {
 		int ret;
 		siginfo_t info;
+		struct timespec tick = { SUPERVISOR_TICK, 0 };
 
 		/* Signals to wait for */
-		ret = sigwaitinfo(&set, &info);
+		ret = sigtimedwait(&set, &info, &tick);
 		if (ret == -1) {
-			syslog(LOG_ERR, "sigwaitinfo: %m");
-		} else {
-			switch (ret) {
-			case SIGHUP:
-				hangup_pending = 1;
-				syslog(LOG_NOTICE, "Signal HUP received");
-				break;
-			case SIGTERM:
-				shutdown_pending = 1;
-				syslog(LOG_NOTICE, "Signal TERM received");
-				break;
-			default:
-				syslog(LOG_ERR, "Signal %d received", ret);
-				break;
+			if (errno == EAGAIN) {
+				supervisor_check();
+				stats_check();
+			} else if (errno != EINTR) {
+				log_msg(LOG_ERR, "sigtimedwait: %m");
 			}
+		} else {
+			sigmain(ret);
 		}
 	}
 
@@ -576,7 +1711,7 @@ worker_main(int *halt)
 	*halt = shutdown_pending;
 
 	if (worker_destroy() == -1) {
-		syslog(LOG_ERR, "worker_destroy: %m");
+		log_msg(LOG_ERR, "worker_destroy: %m");
 	}
 
 	return 0;
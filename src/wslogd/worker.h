@@ -5,11 +5,13 @@
  * Worker module.
  */
 
+struct ws_conf;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int worker_main(int *halt);
+int worker_main(int (*reread)(struct ws_conf *), int *halt);
 
 #ifdef __cplusplus
 }
@@ -19,7 +19,7 @@
 static void
 usage(FILE *std, int status)
 {
-	fprintf(std, "Usage: " PROGNAME " [-l cnt] [-h] [-V] [-S] [-c config]\n");
+	fprintf(std, "Usage: " PROGNAME " [-l cnt] [-h] [-V] [-S] [-s] [-f] [-c config] [-n station]\n");
 
 	exit(status);
 }
@@ -37,23 +37,41 @@ print_loop(const struct ws_loop *p)
 			p->rain_day, p->in_temp, p->in_humidity);
 }
 
-static void
+static int
 dump_loop(size_t nel)
 {
-	int i;
-	const struct ws_loop *p;
+	ssize_t i, sz;
+	size_t nloops, nar;
+	struct ws_loop *buf;
 
-	i = 0;
+	if (nel == 0) {
+		board_size(&nloops, &nar);
+		nel = nloops;
+	}
 
-	do {
-		p = board_peek(i);
+	if ((buf = calloc(nel, sizeof(*buf))) == NULL) {
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		return -1;
+	}
 
-		if (p != NULL) {
-			print_loop(p);
-		}
+	if ((sz = board_copy_loops(buf, 0, nel)) == -1) {
+		fprintf(stderr, "board_copy_loops: %s\n", strerror(errno));
+		goto error;
+	}
 
-		i++;
-	} while (p && (nel == 0 || i < nel));
+	/* Most recent first */
+	for (i = sz - 1; i >= 0; i--) {
+		print_loop(&buf[i]);
+	}
+
+	free(buf);
+
+	return 0;
+
+error:
+	free(buf);
+
+	return -1;
 }
 
 static void
@@ -68,46 +86,285 @@ print_ar(const struct ws_archive *p)
 			p->rain_fall, p->in_temp, p->in_humidity);
 }
 
-static void
+static int
 dump_ar(size_t nel)
 {
-	int i;
-	const struct ws_archive *p;
+	ssize_t i, sz;
+	size_t nloops, nar;
+	struct ws_archive *buf;
+
+	if (nel == 0) {
+		board_size(&nloops, &nar);
+		nel = nar;
+	}
+
+	if ((buf = calloc(nel, sizeof(*buf))) == NULL) {
+		fprintf(stderr, "calloc: %s\n", strerror(errno));
+		return -1;
+	}
+
+	if ((sz = board_copy_ar(buf, 0, nel)) == -1) {
+		fprintf(stderr, "board_copy_ar: %s\n", strerror(errno));
+		goto error;
+	}
+
+	/* Most recent first */
+	for (i = sz - 1; i >= 0; i--) {
+		print_ar(&buf[i]);
+	}
+
+	free(buf);
+
+	return 0;
+
+error:
+	free(buf);
+
+	return -1;
+}
+
+static void
+print_hist(const char *name, const char *stage, const struct board_hist *p)
+{
+	printf("%-8s %-8s %8lu", name, stage, p->count);
+
+	if (p->count) {
+		printf(" %8lu %8lu %8lu %8llu", board_hist_quantile(p, 0.5),
+				board_hist_quantile(p, 0.99), p->max, p->sum / p->count);
+	}
+
+	printf("\n");
+}
+
+static const char *
+health_name(enum board_health health)
+{
+	switch (health) {
+	case BOARD_HEALTH_OK:
+		return "ok";
+	case BOARD_HEALTH_DEGRADED:
+		return "degraded";
+	case BOARD_HEALTH_OPEN:
+		return "open";
+	case BOARD_HEALTH_DEAD:
+		return "dead";
+	case BOARD_HEALTH_DISABLED:
+		return "disabled";
+	default:
+		return "?";
+	}
+}
+
+static int
+dump_stats()
+{
+	size_t i;
+	struct board_stats st;
+
+	if (board_stats(&st) == -1) {
+		fprintf(stderr, "board_stats: %s\n", strerror(errno));
+		return -1;
+	}
+
+	printf("%-8s %-8s %8s %8s %8s %8s %8s %8s %-19s %s\n", "service", "health",
+			"events", "failures", "dropped", "merged", "skipped", "restarts",
+			"last success", "latency");
+
+	for (i = 0; i < st.nsrv; i++) {
+		const struct board_srv *p = &st.srv[i];
+		char buf[20] = "-";
+
+		if (p->last_success) {
+			localftime_r(buf, sizeof(buf), &p->last_success, "%F %T");
+		}
+
+		printf("%-8s %-8s %8lu %8lu %8lu %8lu %8lu %8lu %-19s", p->name,
+				health_name(p->health), p->events, p->failures, p->dropped,
+				p->coalesced, p->skipped, p->restarts, buf);
+
+		if (p->latency.count) {
+			printf(" avg %lluus max %luus",
+					p->latency.sum / p->latency.count, p->latency.max);
+		}
+
+		printf("\n");
+	}
+
+	/* Archive backfill */
+	if (st.backfill.state != BOARD_BACKFILL_NONE) {
+		static const char *state[] = { "none", "running", "done", "failed" };
+		char from[20], current[20];
+
+		localftime_r(from, sizeof(from), &st.backfill.from, "%F %T");
+		localftime_r(current, sizeof(current), &st.backfill.current, "%F %T");
+
+		printf("\nbackfill %s: %lu records, from %s to %s\n",
+				state[st.backfill.state], st.backfill.records, from, current);
+	}
+
+	/* Database writer */
+	printf("\nwriter: %lu saved, %lu lost\n", st.writer.saved, st.writer.lost);
+
+	/* Logging */
+	printf("\nlog: %lu logged, %lu repeated, %lu dropped\n",
+			st.log.logged, st.log.repeated, st.log.dropped);
+	printf("memory: %ldkB resident, %ldkB peak\n",
+			st.memory.rss, st.memory.peak);
+
+	/* Pipeline latency, in microseconds */
+	printf("\n%-8s %-8s %8s %8s %8s %8s %8s\n", "service", "stage", "count",
+			"p50 (us)", "p99", "max", "avg");
+
+	print_hist("sensor", "jitter", &st.hist[BOARD_HIST_JITTER]);
+	print_hist("sensor", "driver", &st.hist[BOARD_HIST_DRV_RT]);
+	print_hist("sensor", "board", &st.hist[BOARD_HIST_PUSH_RT]);
+	print_hist("archive", "driver", &st.hist[BOARD_HIST_DRV_AR]);
+	print_hist("archive", "board", &st.hist[BOARD_HIST_PUSH_AR]);
+	print_hist("archive", "sqlite", &st.hist[BOARD_HIST_SQLITE]);
+	print_hist("archive", "ckpt", &st.hist[BOARD_HIST_CHECKPOINT]);
+	print_hist("-", "dispatch", &st.hist[BOARD_HIST_DISPATCH]);
+
+	for (i = 0; i < st.nsrv; i++) {
+		const struct board_srv *p = &st.srv[i];
+
+		if (p->wait.count) {
+			print_hist(p->name, "queue", &p->wait);
+		}
+
+		print_hist(p->name, "handler", &p->latency);
+
+		if (p->age.count) {
+			print_hist(p->name, "total", &p->age);
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Prints the records pushed to the board, oldest first, until interrupted.
+ *
+ * On each update, every record newer than the last one printed is copied,
+ * so that none is missed when several are pushed between two wakeups.
+ */
+static int
+follow(int use_sensors)
+{
+	ssize_t i, sz;
+	unsigned int seq;
+	size_t nloops, nar;
+	time_t last;
+	struct ws_loop *loop = NULL;
+	struct ws_archive *ar = NULL;
+
+	board_size(&nloops, &nar);
 
-	i = 0;
+	if (use_sensors) {
+		if ((loop = calloc(nloops, sizeof(*loop))) == NULL) {
+			fprintf(stderr, "calloc: %s\n", strerror(errno));
+			goto error;
+		}
+	} else {
+		if ((ar = calloc(nar, sizeof(*ar))) == NULL) {
+			fprintf(stderr, "calloc: %s\n", strerror(errno));
+			goto error;
+		}
+	}
 
-	do {
-		p = board_peek_ar(i);
+	/* Start after the most recent record */
+	seq = board_seq();
+	last = 0;
 
-		if (p != NULL) {
-			print_ar(p);
+	if (use_sensors) {
+		if (board_get(0, loop) == 0) {
+			last = loop->time.tv_sec;
 		}
+	} else {
+		if (board_get_ar(0, ar) == 0) {
+			last = ar->time;
+		}
+	}
+
+	for (;;) {
+		if (board_wait(&seq, -1) == -1) {
+			fprintf(stderr, "board_wait: %s\n", strerror(errno));
+			goto error;
+		}
+
+		if (use_sensors) {
+			if ((sz = board_copy_loops(loop, last, nloops)) == -1) {
+				fprintf(stderr, "board_copy_loops: %s\n", strerror(errno));
+				goto error;
+			}
+
+			for (i = 0; i < sz; i++) {
+				print_loop(&loop[i]);
+			}
+			if (sz > 0) {
+				last = loop[sz - 1].time.tv_sec;
+			}
+		} else {
+			if ((sz = board_copy_ar(ar, last, nar)) == -1) {
+				fprintf(stderr, "board_copy_ar: %s\n", strerror(errno));
+				goto error;
+			}
+
+			for (i = 0; i < sz; i++) {
+				print_ar(&ar[i]);
+			}
+			if (sz > 0) {
+				last = ar[sz - 1].time;
+			}
+		}
+
+		(void) fflush(stdout);
+	}
+
+	free(loop);
+	free(ar);
+
+	return 0;
+
+error:
+	free(loop);
+	free(ar);
 
-		i++;
-	} while (p && (nel == 0 || i < nel));
+	return -1;
 }
 
 int
 main(int argc, char *argv[])
 {
-	int c;
+	int c, ret;
 
 	/* Default parameters */
 	size_t nel = 10;
 	int use_sensors = 0;
+	int use_follow = 0;
+	int use_stats = 0;
 	const char *config = "/etc/wslogd.conf";
+	const char *station = NULL;
 
 	(void) setlocale(LC_ALL, "C");
 
 	/* Parse command line */
-	while ((c = getopt(argc, argv, "hVc:l:S")) != -1) {
+	while ((c = getopt(argc, argv, "hVc:fl:n:sS")) != -1) {
 		switch (c) {
 		case 'c':
 			config = optarg;
 			break;
+		case 'f':
+			use_follow = 1;
+			break;
 		case 'l':
 			nel = atoi(optarg);
 			break;
+		case 'n':
+			station = optarg;
+			break;
+		case 's':
+			use_stats = 1;
+			break;
 		case 'S':
 			use_sensors = 1;
 			break;
@@ -132,17 +389,33 @@ main(int argc, char *argv[])
 		goto error;
 	}
 
+	if (station == NULL) {
+		station = confp->station.name;
+	}
+
 	/* Open shared board */
-	if (board_open(0) == -1) {
+	if (board_open(station, confp->board.file, 0) == -1) {
 		fprintf(stderr, "boad_open: %s\n", strerror(errno));
 		goto error;
 	}
 
 	/* Display */
-	if (use_sensors) {
-		dump_loop(nel);
+	if (use_stats) {
+		ret = dump_stats();
+	} else if (use_sensors) {
+		ret = dump_loop(nel);
 	} else {
-		dump_ar(nel);
+		ret = dump_ar(nel);
+	}
+
+	if (ret == -1) {
+		goto error;
+	}
+
+	if (use_follow && !use_stats) {
+		if (follow(use_sensors) == -1) {
+			goto error;
+		}
 	}
 
 	if (board_unlink() == -1) {
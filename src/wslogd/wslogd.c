@@ -15,11 +15,13 @@
 
 #include "curl.h"
 #include "conf.h"
+#include "log.h"
 #include "worker.h"
 
 #define PROGNAME	"wslogd"
 
 static int archive_freq = -1;
+static const char *conf_file = "/etc/wslogd.conf";
 
 int dry_run = 0;
 
@@ -32,21 +34,35 @@ usage(FILE *std, int status)
 }
 
 static void
-post_config(void)
+post_config(struct ws_conf *cfg)
 {
 	if (archive_freq != -1) {
-		confp->archive.freq = archive_freq;
+		cfg->archive.freq = archive_freq;
 	}
 }
 
+static int
+loop_reread(struct ws_conf *cfg)
+{
+	if (conf_read(conf_file, cfg) == -1) {
+		return -1;
+	}
+
+	post_config(cfg);
+
+	return 0;
+}
+
 static int
 loop_init(void)
 {
-	openlog(PROGNAME, LOG_PID, confp->log_facility);
-	(void) setlogmask(LOG_UPTO(confp->log_level));
+	if (log_open(PROGNAME, confp->log_facility) == -1) {
+		goto error;
+	}
+	(void) log_setmask(LOG_UPTO(confp->log_level));
 
 	if (dry_run) {
-		syslog(LOG_WARNING, "Dry run mode");
+		log_msg(LOG_WARNING, "Dry run mode");
 	}
 
 	/* Need libcurl */
@@ -67,12 +83,11 @@ error:
 static int
 loop_reinit(const char *config_file)
 {
-	conf_free();
-	if (conf_load(config_file) == -1) {
+	if (conf_reload(config_file) == -1) {
 		goto error;
 	}
 
-	post_config();
+	post_config(confp);
 
 	/* (Re)initialize */
 	if (loop_init() == -1) {
@@ -92,7 +107,8 @@ loop_destroy()
 		curl_global_cleanup();
 	}
 
-	closelog();
+	log_close();
+	conf_free();
 }
 
 int
@@ -102,9 +118,6 @@ main(int argc, char *argv[])
 	int ret;
 	int halt;
 
-	/* Default parameters */
-	const char *conf_file = "/etc/wslogd.conf";
-
 	(void) setlocale(LC_ALL, "C");
 
 	/* Parse command line */
@@ -141,7 +154,7 @@ main(int argc, char *argv[])
 		exit(1);
 	}
 
-	post_config();
+	post_config(confp);
 
 	/* Startup */
 	ret = 1;
@@ -151,7 +164,7 @@ main(int argc, char *argv[])
 
 	halt = 0;
 	do {
-		if (worker_main(&halt) == -1) {
+		if (worker_main(loop_reread, &halt) == -1) {
 			goto exit;
 		}
 
@@ -167,9 +180,9 @@ main(int argc, char *argv[])
 
 exit:
 	if (ret == 0) {
-		syslog(LOG_NOTICE, "Shutdown complete");
+		log_msg(LOG_NOTICE, "Shutdown complete");
 	} else {
-		syslog(LOG_ERR, "Shutdown complete (abort)");
+		log_msg(LOG_ERR, "Shutdown complete (abort)");
 	}
 
 	loop_destroy();
@@ -8,6 +8,7 @@
 #include <lauxlib.h>
 #include <sqlite3.h>
 
+#include "libws/conf.h"
 #include "libws/defs.h"
 #include "libws/util.h"
 
@@ -17,6 +18,7 @@
 #include "wsview.h"
 
 static int board = 0;
+static char *station = NULL;
 static sqlite3 *db = NULL;
 
 struct lua_table
@@ -25,6 +27,63 @@ struct lua_table
 	int (*get) (const struct ws_loop *, double *);
 };
 
+static const struct
+{
+	const char *name;
+	int field;
+} loop_fields[] =
+{
+	{ "barometer", WS_BAROMETER },
+	{ "temp", WS_TEMP },
+	{ "humidity", WS_HUMIDITY },
+	{ "wind_speed", WS_WIND_SPEED },
+	{ "wind_dir", WS_WIND_DIR },
+	{ "rain_day", WS_RAIN_DAY },
+	{ "rain_rate", WS_RAIN_RATE },
+	{ "solar_rad", WS_SOLAR_RAD },
+	{ "uv", WS_UV_INDEX },
+	{ "dew_point", WS_DEW_POINT },
+	{ "windchill", WS_WINDCHILL },
+	{ "heat_index", WS_HEAT_INDEX },
+	{ "in_temp", WS_IN_TEMP },
+	{ "in_humidity", WS_IN_HUMIDITY }
+};
+
+static int
+field_search(const char *name)
+{
+	size_t i;
+
+	for (i = 0; name != NULL && i < array_size(loop_fields); i++) {
+		if (!strcmp(loop_fields[i].name, name)) {
+			return loop_fields[i].field;
+		}
+	}
+
+	return -1;
+}
+
+static int
+board_attach(lua_State *L)
+{
+	if (!board) {
+		const char *name = station;
+
+		if (name == NULL) {
+			name = getenv("WSLOG_STATION");
+		}
+
+		if (board_open(name, getenv("WSLOG_BOARD"), 0) == -1) {
+			lua_pushfstring(L, "board_open: %s", strerror(errno));
+			return -1;
+		}
+
+		board = 1;
+	}
+
+	return 0;
+}
+
 static void
 db_open(const char *path)
 {
@@ -246,29 +305,19 @@ wsview_current(lua_State *L)
 	};
 
 	/* Read shared board */
-	if (!board) {
-		if (board_open(0) == -1) {
-			lua_pushfstring(L, "board_open: %s", strerror(errno));
-			goto error;
-		}
-
-		board = 1;
-	}
-
-	if (board_lock() == -1) {
-		lua_pushfstring(L, "board_lock: %s", strerror(errno));
+	if (board_attach(L) == -1) {
 		goto error;
 	}
 
-	bufp = board_peek(0);
-
-	if (bufp != NULL) {
-		memcpy(&buf, bufp, sizeof(buf));
-	}
+	if (board_get(0, &buf) == -1) {
+		if (errno != ENODATA) {
+			lua_pushfstring(L, "board_get: %s", strerror(errno));
+			goto error;
+		}
 
-	if (board_unlock() == -1) {
-		lua_pushfstring(L, "board_unlock: %s", strerror(errno));
-		goto error;
+		bufp = NULL;
+	} else {
+		bufp = &buf;
 	}
 
 	/* Lua result */
@@ -301,6 +350,192 @@ error:
 	return lua_error(L);
 }
 
+/**
+ * Aggregates recent sensor values from the board.
+ *
+ * Takes a field name (as in current()), an aggregate ("min", "max", "avg",
+ * "sum" or "count"), and a time range. Returns the value, or nil when no
+ * value is available.
+ */
+static int
+wsview_recent(lua_State *L)
+{
+	size_t i;
+	int field, type;
+	double value;
+	const char *aggr = lua_tostring(L, 2);
+	time_t lower = lua_tonumber(L, 3);
+	time_t upper = lua_tonumber(L, 4);
+
+	const struct { const char *name; int type; } aggrs[] =
+	{
+		{ "min", AGGR_MIN },
+		{ "max", AGGR_MAX },
+		{ "avg", AGGR_AVG },
+		{ "sum", AGGR_SUM },
+		{ "count", AGGR_COUNT }
+	};
+
+	field = field_search(lua_tostring(L, 1));
+	type = -1;
+	for (i = 0; aggr != NULL && i < array_size(aggrs); i++) {
+		if (!strcmp(aggrs[i].name, aggr)) {
+			type = aggrs[i].type;
+		}
+	}
+	if (field == -1 || type == -1) {
+		lua_pushstring(L, "recent: invalid field or aggregate");
+		goto error;
+	}
+
+	/* Read shared board */
+	if (board_attach(L) == -1) {
+		goto error;
+	}
+
+	if (board_aggr(field, type, lower, upper, &value) == -1) {
+		if (errno != ENODATA) {
+			lua_pushfstring(L, "board_aggr: %s", strerror(errno));
+			goto error;
+		}
+
+		return 0;
+	}
+
+	lua_pushnumber(L, round_scale(value, 2));
+
+	return 1;
+
+error:
+	return lua_error(L);
+}
+
+/**
+ * Returns rolling window statistics from the board.
+ *
+ * Takes a window length (a duration like "10m", or "day"), and a field name
+ * (as in current(), or "wind" for the wind vector). Returns a table with min,
+ * max, min_time, max_time, mean, sum and count (speed and dir for the wind),
+ * or nil when no value is available.
+ */
+static int
+wsview_window(lua_State *L)
+{
+	int ret;
+	long len;
+	const char *period = lua_tostring(L, 1);
+	const char *name = lua_tostring(L, 2);
+
+	if (period != NULL && !strcmp(period, "day")) {
+		len = WIN_DAY;
+	} else if (period == NULL || ws_getduration(period, &len) == -1) {
+		lua_pushstring(L, "window: invalid length");
+		goto error;
+	}
+
+	/* Read shared board */
+	if (board_attach(L) == -1) {
+		goto error;
+	}
+
+	if (name != NULL && !strcmp(name, "wind")) {
+		double speed, dir;
+
+		ret = board_window_wind(len, &speed, &dir);
+
+		if (ret == 0) {
+			lua_newtable(L);
+			lua_pushnumber(L, round_scale(speed, 2));
+			lua_setfield(L, -2, "speed");
+			lua_pushnumber(L, round_scale(dir, 0));
+			lua_setfield(L, -2, "dir");
+		}
+	} else {
+		int field;
+		struct win_stat st;
+
+		if ((field = field_search(name)) == -1) {
+			lua_pushstring(L, "window: invalid field");
+			goto error;
+		}
+
+		ret = board_window(len, field, &st);
+
+		if (ret == 0) {
+			lua_newtable(L);
+			lua_pushnumber(L, round_scale(st.min, 2));
+			lua_setfield(L, -2, "min");
+			lua_pushinteger(L, st.min_time);
+			lua_setfield(L, -2, "min_time");
+			lua_pushnumber(L, round_scale(st.max, 2));
+			lua_setfield(L, -2, "max");
+			lua_pushinteger(L, st.max_time);
+			lua_setfield(L, -2, "max_time");
+			lua_pushnumber(L, round_scale(st.sum / st.count, 2));
+			lua_setfield(L, -2, "mean");
+			lua_pushnumber(L, round_scale(st.sum, 2));
+			lua_setfield(L, -2, "sum");
+			lua_pushinteger(L, st.count);
+			lua_setfield(L, -2, "count");
+		}
+	}
+
+	if (ret == -1) {
+		if (errno != ENODATA) {
+			lua_pushfstring(L, "board_window: %s", strerror(errno));
+			goto error;
+		}
+
+		return 0;
+	}
+
+	return 1;
+
+error:
+	return lua_error(L);
+}
+
+/**
+ * Waits for a board update.
+ *
+ * Takes the last known board sequence (or nil), and a timeout in milliseconds
+ * (or nil to wait forever). Returns the new sequence, or nil on timeout. When
+ * no sequence is given, the current one is returned immediately.
+ */
+static int
+wsview_wait(lua_State *L)
+{
+	unsigned int seq;
+	int timeout;
+
+	if (board_attach(L) == -1) {
+		goto error;
+	}
+
+	if (lua_isnoneornil(L, 1)) {
+		seq = board_seq();
+	} else {
+		seq = lua_tointeger(L, 1);
+		timeout = lua_isnoneornil(L, 2) ? -1 : lua_tointeger(L, 2);
+
+		if (board_wait(&seq, timeout) == -1) {
+			if (errno == ETIMEDOUT) {
+				return 0;
+			}
+
+			lua_pushfstring(L, "board_wait: %s", strerror(errno));
+			goto error;
+		}
+	}
+
+	lua_pushinteger(L, seq);
+
+	return 1;
+
+error:
+	return lua_error(L);
+}
+
 static int
 wsview_wind_dir(lua_State *L)
 {
@@ -325,6 +560,25 @@ wsview_open(lua_State *L)
 	return 0;
 }
 
+/**
+ * Selects the station board to read, by name (or nil for the default one).
+ */
+static int
+wsview_station(lua_State *L)
+{
+	const char *name = lua_tostring(L, 1);
+
+	if (board) {
+		board_unlink();
+		board = 0;
+	}
+
+	free(station);
+	station = (name == NULL) ? NULL : strdup(name);
+
+	return 0;
+}
+
 static int
 wsview_close(lua_State *L)
 {
@@ -348,10 +602,14 @@ luaopen_wsview(lua_State *L)
 	luaL_Reg wslib[] =
 	{
 		{ "current", wsview_current },
+		{ "recent", wsview_recent },
+		{ "window", wsview_window },
+		{ "wait", wsview_wait },
 		{ "wind_dir", wsview_wind_dir },
 		{ "aggregate", wsview_aggregate },
 		{ "archive", wsview_archive },
 		{ "open", wsview_open },
+		{ "station", wsview_station },
 		{ "close", wsview_close },
 		{ NULL, NULL }
 	};
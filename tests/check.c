@@ -15,8 +15,12 @@ main(void)
 	sr = srunner_create(NULL);
 
 	srunner_add_suite(sr, suite_aggregate());
+	srunner_add_suite(sr, suite_board());
+	srunner_add_suite(sr, suite_conf());
 	srunner_add_suite(sr, suite_crc_ccitt());
+	srunner_add_suite(sr, suite_dataset());
 	srunner_add_suite(sr, suite_nybble());
+	srunner_add_suite(sr, suite_queue());
 	srunner_add_suite(sr, suite_util());
 
 	srunner_add_suite(sr, suite_vantage());
@@ -0,0 +1,176 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "libws/defs.h"
+#include "libws/aggregate.h"
+#include "wslogd/board.h"
+
+#include "suites.h"
+
+#define SRV_SENSOR 0
+#define SRV_ARCHIVE 1
+
+static char path[32];
+
+static void
+setup(void)
+{
+	int fd;
+
+	strcpy(path, "/tmp/check_board.XXXXXX");
+	fd = mkstemp(path);
+	ck_assert_int_ne(-1, fd);
+	(void) close(fd);
+
+	ck_assert_int_ne(-1, board_open("check", path, O_CREAT,
+			(size_t) 16, (size_t) 4, 0, (const long *) NULL, (size_t) 0));
+
+	board_stat_register(SRV_SENSOR, "sensor");
+	board_stat_register(SRV_ARCHIVE, "archive");
+}
+
+static void
+setup_windows(void)
+{
+	int fd;
+	long windows[] = { 60 };
+
+	strcpy(path, "/tmp/check_board.XXXXXX");
+	fd = mkstemp(path);
+	ck_assert_int_ne(-1, fd);
+	(void) close(fd);
+
+	ck_assert_int_ne(-1, board_open("check", path, O_CREAT,
+			(size_t) 16, (size_t) 4, 0, windows, (size_t) 1));
+}
+
+static void
+teardown(void)
+{
+	(void) board_unlink();
+	(void) unlink(path);
+}
+
+START_TEST(test_stat_event)
+{
+	struct timespec start;
+	struct board_stats st;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &start);
+
+	board_stat_event(SRV_SENSOR, 0, &start);
+	board_stat_event(SRV_ARCHIVE, -1, &start);
+
+	ck_assert_int_eq(0, board_stats(&st));
+	ck_assert_int_eq(2, st.nsrv);
+
+	ck_assert_int_eq(1, st.srv[SRV_SENSOR].events);
+	ck_assert_int_eq(0, st.srv[SRV_SENSOR].failures);
+	ck_assert_int_eq(1, st.srv[SRV_ARCHIVE].events);
+	ck_assert_int_eq(1, st.srv[SRV_ARCHIVE].failures);
+}
+END_TEST
+
+/* Writer counters are kept apart from the services ones */
+START_TEST(test_stat_writer)
+{
+	struct board_stats st;
+
+	board_stat_writer(14, 2);
+	board_stat_writer(1, 0);
+
+	ck_assert_int_eq(0, board_stats(&st));
+
+	ck_assert_int_eq(15, st.writer.saved);
+	ck_assert_int_eq(2, st.writer.lost);
+	ck_assert_int_eq(0, st.srv[SRV_SENSOR].events);
+	ck_assert_int_eq(0, st.srv[SRV_SENSOR].failures);
+	ck_assert_int_eq(0, st.srv[SRV_ARCHIVE].events);
+	ck_assert_int_eq(0, st.srv[SRV_ARCHIVE].failures);
+}
+END_TEST
+
+static void
+push_temp(time_t t, float temp)
+{
+	struct ws_loop loop;
+
+	memset(&loop, 0, sizeof(loop));
+	loop.time.tv_sec = t;
+	loop.wl_mask = WF_TEMP;
+	loop.temp = temp;
+
+	board_push(&loop);
+}
+
+/* Expired samples leave the window, with or without a new sample */
+START_TEST(test_window_expire)
+{
+	struct win_stat st;
+	time_t t = 1700000000;
+
+	push_temp(t, 10);
+	push_temp(t + 30, 20);
+
+	ck_assert_int_eq(0, board_window(60, WS_TEMP, &st));
+	ck_assert_int_eq(2, st.count);
+	ck_assert_double_eq(10, st.min);
+	ck_assert_double_eq(20, st.max);
+
+	/* Lowest value expired */
+	push_temp(t + 60, 15);
+
+	ck_assert_int_eq(0, board_window(60, WS_TEMP, &st));
+	ck_assert_int_eq(2, st.count);
+	ck_assert_double_eq(35, st.sum);
+	ck_assert_double_eq(15, st.min);
+	ck_assert_int_eq(t + 60, st.min_time);
+
+	/* No sample */
+	board_window_expire(t + 90);
+
+	ck_assert_int_eq(0, board_window(60, WS_TEMP, &st));
+	ck_assert_int_eq(1, st.count);
+	ck_assert_double_eq(15, st.max);
+
+	board_window_expire(t + 120);
+
+	ck_assert_int_eq(-1, board_window(60, WS_TEMP, &st));
+	ck_assert_int_eq(ENODATA, errno);
+}
+END_TEST
+
+Suite *
+suite_board(void)
+{
+	Suite *s;
+	TCase *tc_stats;
+	TCase *tc_windows;
+
+	s = suite_create("board");
+
+	/* Counters test cases */
+	tc_stats = tcase_create("stats");
+	tcase_add_checked_fixture(tc_stats, setup, teardown);
+	tcase_add_test(tc_stats, test_stat_event);
+	tcase_add_test(tc_stats, test_stat_writer);
+
+	/* Rolling windows test cases */
+	tc_windows = tcase_create("windows");
+	tcase_add_checked_fixture(tc_windows, setup_windows, teardown);
+	tcase_add_test(tc_windows, test_window_expire);
+
+	suite_add_tcase(s, tc_stats);
+	suite_add_tcase(s, tc_windows);
+
+	return s;
+}
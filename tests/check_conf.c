@@ -0,0 +1,64 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+#include <errno.h>
+
+#include "libws/conf.h"
+
+#include "suites.h"
+
+#define ck_assert_duration(str, v) \
+	do { \
+		long res; \
+		ck_assert_int_eq(ws_getduration(str, &res), 0); \
+		ck_assert_int_eq(res, v); \
+	} while (0)
+
+#define ck_assert_duration_err(str, e) \
+	do { \
+		long res; \
+		ck_assert_int_eq(ws_getduration(str, &res), -1); \
+		ck_assert_int_eq(errno, e); \
+	} while (0)
+
+START_TEST(test_getduration)
+{
+	ck_assert_duration("0", 0);
+	ck_assert_duration("90", 90);
+	ck_assert_duration("90s", 90);
+	ck_assert_duration("10m", 600);
+	ck_assert_duration("24h", 86400);
+	ck_assert_duration("7d", 604800);
+	ck_assert_duration("2w", 1209600);
+}
+END_TEST
+
+START_TEST(test_getduration_invalid)
+{
+	ck_assert_duration_err("", EINVAL);
+	ck_assert_duration_err("h", EINVAL);
+	ck_assert_duration_err("-1h", EINVAL);
+	ck_assert_duration_err("1y", EINVAL);
+	ck_assert_duration_err("1hh", EINVAL);
+}
+END_TEST
+
+Suite *
+suite_conf(void)
+{
+	Suite *s;
+	TCase *tc_core;
+
+	s = suite_create("conf");
+
+	/* Core test cases */
+	tc_core = tcase_create("core");
+	tcase_add_test(tc_core, test_getduration);
+	tcase_add_test(tc_core, test_getduration_invalid);
+
+	suite_add_tcase(s, tc_core);
+
+	return s;
+}
@@ -0,0 +1,217 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+#include <string.h>
+
+#include "libws/defs.h"
+#include "wslogd/dataset.h"
+
+#include "suites.h"
+
+static struct ws_loop
+loop_round_trip(const struct ws_loop *p)
+{
+	struct ws_loop buf;
+	struct ws_loop_pack pbuf;
+
+	ws_loop_pack(&pbuf, p);
+	ws_loop_unpack(&buf, &pbuf);
+
+	return buf;
+}
+
+static struct ws_archive
+ar_round_trip(const struct ws_archive *p)
+{
+	struct ws_archive buf;
+	struct ws_archive_pack pbuf;
+
+	ws_archive_pack(&pbuf, p);
+	ws_archive_unpack(&buf, &pbuf);
+
+	return buf;
+}
+
+START_TEST(test_loop_pack)
+{
+	struct ws_loop l, u;
+
+	memset(&l, 0, sizeof(l));
+	l.time.tv_sec = 1500000000;
+	l.time.tv_nsec = 123456789;
+	l.wl_mask = WF_BAROMETER | WF_TEMP | WF_HUMIDITY | WF_WIND_SPEED
+		| WF_WIND_DIR | WF_RAIN_DAY | WF_SOLAR_RAD | WF_UV_INDEX
+		| WF_DEW_POINT | WF_IN_HUMIDITY;
+	l.barometer = 1013.2;
+	l.temp = -12.3;
+	l.humidity = 87;
+	l.wind_speed = 4.5;
+	l.wind_dir = 270;
+	l.rain_day = 12.8;
+	l.solar_rad = 640;
+	l.uv_idx = 6.4;
+	l.dew_point = -15.2;
+	l.in_humidity = 45;
+
+	u = loop_round_trip(&l);
+
+	ck_assert_int_eq(1500000000, u.time.tv_sec);
+	ck_assert_int_eq(123000000, u.time.tv_nsec);
+	ck_assert_int_eq(l.wl_mask, u.wl_mask);
+	ck_assert_double_eq(1013.2, u.barometer);
+	ck_assert_double_eq(-12.3, u.temp);
+	ck_assert_int_eq(87, u.humidity);
+	ck_assert_double_eq(4.5, u.wind_speed);
+	ck_assert_int_eq(270, u.wind_dir);
+	ck_assert_double_eq(12.8, u.rain_day);
+	ck_assert_int_eq(640, u.solar_rad);
+	ck_assert_double_eq(6.4, u.uv_idx);
+	ck_assert_double_eq(-15.2, u.dew_point);
+	ck_assert_int_eq(45, u.in_humidity);
+}
+END_TEST
+
+START_TEST(test_loop_pack_round)
+{
+	struct ws_loop l, u;
+
+	memset(&l, 0, sizeof(l));
+	l.wl_mask = WF_TEMP | WF_WIND_SPEED | WF_RAIN_RATE;
+	l.temp = 21.04;
+	l.wind_speed = 3.06;
+	l.rain_rate = 0.04;
+
+	u = loop_round_trip(&l);
+
+	ck_assert_double_eq(21.0, u.temp);
+	ck_assert_double_eq(3.1, u.wind_speed);
+	ck_assert_double_eq(0.0, u.rain_rate);
+}
+END_TEST
+
+START_TEST(test_loop_pack_saturate)
+{
+	struct ws_loop l, u;
+
+	memset(&l, 0, sizeof(l));
+	l.wl_mask = WF_BAROMETER | WF_TEMP | WF_WIND_SPEED | WF_RAIN_24H
+		| WF_UV_INDEX | WF_IN_TEMP;
+	l.barometer = -1.0;
+	l.temp = 5000.0;
+	l.wind_speed = 10000.0;
+	l.rain_24h = 7000.0;
+	l.uv_idx = 30.0;
+	l.in_temp = -5000.0;
+
+	u = loop_round_trip(&l);
+
+	ck_assert_double_eq(0.0, u.barometer);
+	ck_assert_double_eq(3276.7, u.temp);
+	ck_assert_double_eq(6553.5, u.wind_speed);
+	ck_assert_double_eq(6553.5, u.rain_24h);
+	ck_assert_double_eq(25.5, u.uv_idx);
+	ck_assert_double_eq(-3276.8, u.in_temp);
+}
+END_TEST
+
+START_TEST(test_loop_pack_invalid)
+{
+	struct ws_loop l, u;
+
+	memset(&l, 0, sizeof(l));
+	l.wl_mask = WF_TEMP;
+	l.temp = 18.5;
+	l.barometer = 1020.0;
+	l.humidity = 60;
+
+	u = loop_round_trip(&l);
+
+	ck_assert_int_eq(WF_TEMP, u.wl_mask);
+	ck_assert_double_eq(18.5, u.temp);
+	ck_assert_double_eq(0.0, u.barometer);
+	ck_assert_int_eq(0, u.humidity);
+}
+END_TEST
+
+START_TEST(test_archive_pack)
+{
+	struct ws_archive a, u;
+
+	memset(&a, 0, sizeof(a));
+	a.time = 1500000000;
+	a.interval = 300;
+	a.wl_mask = WF_BAROMETER | WF_TEMP | WF_HI_TEMP | WF_LO_TEMP
+		| WF_WIND_SPEED | WF_WIND_SAMPLES | WF_HI_WIND_DIR | WF_RAIN
+		| WF_HI_RAIN_RATE | WF_IN_TEMP;
+	a.barometer = 998.7;
+	a.temp = 25.3;
+	a.hi_temp = 26.1;
+	a.lo_temp = -0.4;
+	a.avg_wind_speed = 2.2;
+	a.wind_samples = 117;
+	a.hi_wind_dir = 225;
+	a.rain_fall = 0.25;
+	a.hi_rain_rate = 30.5;
+	a.in_temp = 19.9;
+
+	u = ar_round_trip(&a);
+
+	ck_assert_int_eq(1500000000, u.time);
+	ck_assert_int_eq(300, u.interval);
+	ck_assert_int_eq(a.wl_mask, u.wl_mask);
+	ck_assert_double_eq(998.7, u.barometer);
+	ck_assert_double_eq(25.3, u.temp);
+	ck_assert_double_eq(26.1, u.hi_temp);
+	ck_assert_double_eq(-0.4, u.lo_temp);
+	ck_assert_double_eq(2.2, u.avg_wind_speed);
+	ck_assert_int_eq(117, u.wind_samples);
+	ck_assert_int_eq(225, u.hi_wind_dir);
+	ck_assert_double_eq(0.25, u.rain_fall);
+	ck_assert_double_eq(30.5, u.hi_rain_rate);
+	ck_assert_double_eq(19.9, u.in_temp);
+}
+END_TEST
+
+START_TEST(test_archive_pack_saturate)
+{
+	struct ws_archive a, u;
+
+	memset(&a, 0, sizeof(a));
+	a.wl_mask = WF_TEMP | WF_LO_TEMP | WF_HI_WIND_SPEED | WF_RAIN;
+	a.temp = 4000.0;
+	a.lo_temp = -4000.0;
+	a.hi_wind_speed = -3.0;
+	a.rain_fall = 1000.0;
+
+	u = ar_round_trip(&a);
+
+	ck_assert_double_eq(3276.7, u.temp);
+	ck_assert_double_eq(-3276.8, u.lo_temp);
+	ck_assert_double_eq(0.0, u.hi_wind_speed);
+	ck_assert_double_eq(655.35, u.rain_fall);
+}
+END_TEST
+
+Suite *
+suite_dataset(void)
+{
+	Suite *s;
+	TCase *tc_pack;
+
+	s = suite_create("dataset");
+
+	/* Packed encoding test cases */
+	tc_pack = tcase_create("pack");
+	tcase_add_test(tc_pack, test_loop_pack);
+	tcase_add_test(tc_pack, test_loop_pack_round);
+	tcase_add_test(tc_pack, test_loop_pack_saturate);
+	tcase_add_test(tc_pack, test_loop_pack_invalid);
+	tcase_add_test(tc_pack, test_archive_pack);
+	tcase_add_test(tc_pack, test_archive_pack_saturate);
+
+	suite_add_tcase(s, tc_pack);
+
+	return s;
+}
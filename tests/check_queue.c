@@ -0,0 +1,187 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <check.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "wslogd/queue.h"
+
+#include "suites.h"
+
+#define NEL 4
+
+static int efd = -1;
+static struct queue q;
+
+static void
+setup(void)
+{
+	efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	ck_assert_int_ne(-1, efd);
+}
+
+static void
+teardown(void)
+{
+	queue_destroy(&q);
+	(void) close(efd);
+}
+
+/* Number of wakeups signaled since the last call */
+static uint64_t
+wakeups(void)
+{
+	uint64_t cnt;
+
+	if (read(efd, &cnt, sizeof(cnt)) == -1) {
+		return 0;
+	}
+
+	return cnt;
+}
+
+START_TEST(test_queue_init)
+{
+	ck_assert_int_eq(-1, queue_init(&q, 0, sizeof(int), efd, QUEUE_ALL));
+	ck_assert_int_eq(EINVAL, errno);
+
+	ck_assert_int_eq(0, queue_init(&q, 0, sizeof(int), efd, QUEUE_LATEST));
+	ck_assert_int_eq(1, q.nel);
+}
+END_TEST
+
+START_TEST(test_queue_empty)
+{
+	int v;
+
+	ck_assert_int_eq(0, queue_init(&q, NEL, sizeof(v), efd, QUEUE_ALL));
+
+	ck_assert_int_eq(-1, queue_pop(&q, &v));
+	ck_assert_int_eq(EAGAIN, errno);
+	ck_assert_int_eq(0, wakeups());
+}
+END_TEST
+
+START_TEST(test_queue_wrap)
+{
+	int i, v;
+
+	ck_assert_int_eq(0, queue_init(&q, NEL, sizeof(v), efd, QUEUE_ALL));
+
+	/* Counters go past the capacity */
+	for (i = 0; i < 3 * NEL; i++) {
+		ck_assert_int_eq(0, queue_push(&q, &i));
+		ck_assert_int_eq(0, queue_push(&q, &(int) { -i }));
+
+		ck_assert_int_eq(0, queue_pop(&q, &v));
+		ck_assert_int_eq(i, v);
+		ck_assert_int_eq(0, queue_pop(&q, &v));
+		ck_assert_int_eq(-i, v);
+	}
+
+	ck_assert_int_eq(-1, queue_pop(&q, &v));
+	ck_assert_int_eq(6 * NEL, wakeups());
+}
+END_TEST
+
+START_TEST(test_queue_all)
+{
+	int i, v;
+
+	ck_assert_int_eq(0, queue_init(&q, NEL, sizeof(v), efd, QUEUE_ALL));
+
+	for (i = 0; i < NEL; i++) {
+		ck_assert_int_eq(0, queue_push(&q, &i));
+	}
+
+	/* Full: the new element is dropped */
+	ck_assert_int_eq(-1, queue_push(&q, &i));
+	ck_assert_int_eq(EAGAIN, errno);
+	ck_assert_int_eq(NEL, wakeups());
+
+	for (i = 0; i < NEL; i++) {
+		ck_assert_int_eq(0, queue_pop(&q, &v));
+		ck_assert_int_eq(i, v);
+	}
+	ck_assert_int_eq(-1, queue_pop(&q, &v));
+}
+END_TEST
+
+START_TEST(test_queue_drop_oldest)
+{
+	int i, v;
+
+	ck_assert_int_eq(0, queue_init(&q, NEL, sizeof(v), efd, QUEUE_DROP_OLDEST));
+
+	for (i = 0; i < NEL; i++) {
+		ck_assert_int_eq(0, queue_push(&q, &i));
+	}
+
+	/* Full: the oldest elements are dropped */
+	ck_assert_int_eq(1, queue_push(&q, &i));
+	i++;
+	ck_assert_int_eq(1, queue_push(&q, &i));
+	ck_assert_int_eq(NEL + 2, wakeups());
+
+	for (i = 2; i < NEL + 2; i++) {
+		ck_assert_int_eq(0, queue_pop(&q, &v));
+		ck_assert_int_eq(i, v);
+	}
+	ck_assert_int_eq(-1, queue_pop(&q, &v));
+}
+END_TEST
+
+START_TEST(test_queue_latest)
+{
+	int v;
+
+	/* Capacity is forced to one element */
+	ck_assert_int_eq(0, queue_init(&q, NEL, sizeof(v), efd, QUEUE_LATEST));
+
+	ck_assert_int_eq(0, queue_push(&q, &(int) { 1 }));
+	ck_assert_int_eq(1, queue_push(&q, &(int) { 2 }));
+	ck_assert_int_eq(1, queue_push(&q, &(int) { 3 }));
+	ck_assert_int_eq(3, wakeups());
+
+	ck_assert_int_eq(0, queue_pop(&q, &v));
+	ck_assert_int_eq(3, v);
+	ck_assert_int_eq(-1, queue_pop(&q, &v));
+
+	/* Not full once popped */
+	ck_assert_int_eq(0, queue_push(&q, &(int) { 4 }));
+	ck_assert_int_eq(0, queue_pop(&q, &v));
+	ck_assert_int_eq(4, v);
+}
+END_TEST
+
+Suite *
+suite_queue(void)
+{
+	Suite *s;
+	TCase *tc_core, *tc_policy;
+
+	s = suite_create("queue");
+
+	/* Core test cases */
+	tc_core = tcase_create("core");
+	tcase_add_checked_fixture(tc_core, setup, teardown);
+	tcase_add_test(tc_core, test_queue_init);
+	tcase_add_test(tc_core, test_queue_empty);
+	tcase_add_test(tc_core, test_queue_wrap);
+
+	/* Full queue policies */
+	tc_policy = tcase_create("policy");
+	tcase_add_checked_fixture(tc_policy, setup, teardown);
+	tcase_add_test(tc_policy, test_queue_all);
+	tcase_add_test(tc_policy, test_queue_drop_oldest);
+	tcase_add_test(tc_policy, test_queue_latest);
+
+	suite_add_tcase(s, tc_core);
+	suite_add_tcase(s, tc_policy);
+
+	return s;
+}
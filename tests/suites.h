@@ -12,9 +12,13 @@ extern "C" {
 #endif
 
 Suite *suite_util(void);
+Suite *suite_conf(void);
 Suite *suite_nybble(void);
 Suite *suite_crc_ccitt(void);
 Suite *suite_aggregate(void);
+Suite *suite_board(void);
+Suite *suite_dataset(void);
+Suite *suite_queue(void);
 
 Suite *suite_vantage(void);
 